@@ -0,0 +1,84 @@
+#ifndef BENCH_HPP
+#define BENCH_HPP
+
+/**
+ * @file bench.hpp
+ * @author Etienne SANTOUL github.com/esantoul
+ * @brief Timing loop & throughput report shared by the benchmarks
+ * @version 0.1
+ * @date 2021-02-04
+ *
+ * @copyright BSD 2-Clause License. Copyright (c) 2021, Etienne SANTOUL. All rights reserved.
+ */
+
+#include "simd_config.hpp"
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+
+namespace bench
+{
+  // Kernel path selected by simd_config.hpp
+  constexpr const char *simd()
+  {
+#if defined(MIDI_SIMD_AVX2)
+    return "avx2";
+#elif defined(MIDI_SIMD_SSE2)
+    return "sse2";
+#else
+    return "scalar";
+#endif
+  }
+
+  // Keeps a result alive so that the measured work is not optimized out
+  template <typename T>
+  inline void keep(const T &value)
+  {
+    asm volatile("" : : "g"(&value) : "memory");
+  }
+
+  /**
+   * @brief Best time of `fn()` over runs totalling at least `budget` seconds
+   * @return seconds per run
+   */
+  template <typename Fun_t>
+  double best(Fun_t &&fn, double budget = 0.5)
+  {
+    using Clock = std::chrono::steady_clock;
+    double best = 1e30;
+    double total = 0;
+    do
+    {
+      const auto t0 = Clock::now();
+      fn();
+      const double s = std::chrono::duration<double>(Clock::now() - t0).count();
+      best = s < best ? s : best;
+      total += s;
+    } while (total < budget);
+    return best;
+  }
+
+  /**
+   * @brief Prints a throughput line: `name [path] value unit`
+   * @param amount work done by one run, in millions of `unit`
+   */
+  inline void report(const char *name, double seconds, double amount, const char *unit)
+  {
+    std::printf("%-40s [%-6s] %10.1f %s\n", name, simd(), amount / seconds, unit);
+  }
+
+  // xorshift32, reproducible corpora across runs
+  struct Rng
+  {
+    std::uint32_t state;
+    std::uint32_t operator()()
+    {
+      state ^= state << 13;
+      state ^= state >> 17;
+      state ^= state << 5;
+      return state;
+    }
+  };
+} // namespace bench
+
+#endif // BENCH_HPP
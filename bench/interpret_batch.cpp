@@ -0,0 +1,129 @@
+/**
+ * @file interpret_batch.cpp
+ * @author Etienne SANTOUL github.com/esantoul
+ * @brief MidiBytes::InterpretBatch throughput in messages/second, against the Insight + Interpret loop it replaces, and
+ * MidiBytes::InterpretWords throughput in words/second, against a packet by packet MidiBytes::M2::method loop
+ * @version 0.1
+ * @date 2021-02-04
+ *
+ * @copyright BSD 2-Clause License. Copyright (c) 2021, Etienne SANTOUL. All rights reserved.
+ */
+
+#define MIDI_PARSER_ENABLE_MIDI2
+
+#include "bench.hpp"
+#include "midi_batch.hpp"
+#include "midi_encode.hpp"
+#include "../src/midi_parser.cpp.template"
+#include <cstdint>
+#include <vector>
+
+namespace
+{
+  constexpr std::size_t kMessages = 1 << 20;
+
+  // Channel voice messages over 4 channels with a timing clock every 64 messages
+  std::vector<std::uint8_t> corpus(bool runningStatus)
+  {
+    constexpr EventType types[] = {EventType::NoteOn, EventType::NoteOff, EventType::ControlChange, EventType::PitchBend,
+                                   EventType::ChannelPressure, EventType::ProgramChange};
+    bench::Rng rng{0x2021};
+    std::vector<std::uint8_t> bytes(3 * kMessages);
+    MidiEncoder encoder{bytes.data(), bytes.size(), runningStatus};
+    for (std::size_t i = 0; i < kMessages; ++i)
+    {
+      MidiEvent e{i % 64 ? types[rng() % 6] : EventType::TimingClock, 1, 0, std::uint8_t(rng() % 4), std::uint8_t(rng() & 0x7F)};
+      e.value = rng() & 0x3FFF;
+      encoder.append(e);
+    }
+    bytes.resize(encoder.size());
+    return bytes;
+  }
+
+  // The per message loop InterpretBatch replaces: full status bytes only
+  std::size_t scalarLoop(const std::uint8_t *bytes, std::size_t length, MidiEvent *events)
+  {
+    std::size_t n = 0;
+    for (std::size_t pos = 0; pos < length;)
+    {
+      const MidiSize sz = MidiBytes::Insight(bytes[pos]);
+      const std::size_t len = sz.status() == MidiSize::Status::Set ? sz.value() : 1;
+      if (pos + len > length)
+        break;
+      n += MidiBytes::Interpret(bytes + pos, len, events + n).status() == ParseInfo::E::SUCCESS;
+      pos += len;
+    }
+    return n;
+  }
+
+  // MIDI 2.0 channel voice packets over 4 groups, with a MIDI 1.0 channel voice packet every 4 & a JR timestamp every 64
+  std::vector<std::uint32_t> words()
+  {
+    constexpr EventType types[] = {EventType::NoteOn, EventType::NoteOff, EventType::ControlChange, EventType::PitchBend,
+                                   EventType::ChannelPressure, EventType::PolyPressure};
+    bench::Rng rng{0x2021};
+    std::vector<std::uint32_t> w(2 * kMessages);
+    UmpEncoder encoder{w.data(), w.size()};
+    for (std::size_t i = 0; i < kMessages; ++i)
+    {
+      MidiEvent e{i % 64 ? types[rng() % 6] : EventType::JRTimestamp, std::uint8_t(i % 4 ? 2 : 1), std::uint8_t(rng() % 4),
+                  std::uint8_t(rng() % 16), std::uint8_t(rng() & 0x7F)};
+      e.value = e.protocol == 2 ? rng() : rng() & 0x3FFF;
+      e.value = e.type == EventType::JRTimestamp ? rng() & 0xFFFF : e.value;
+      encoder.append(e);
+    }
+    w.resize(encoder.size());
+    return w;
+  }
+
+  // The per packet loop InterpretWords replaces
+  std::size_t packetLoop(const std::uint32_t *w, std::size_t count, MidiEvent *events)
+  {
+    std::size_t n = 0;
+    for (std::size_t pos = 0; pos < count;)
+    {
+      const std::size_t sz = UmpFraming::packetWords(w[pos]);
+      std::uint8_t packet[16];
+      UmpFraming::toBytes(w + pos, sz, packet);
+      n += MidiBytes::M2::method(packet, 4 * sz, events + n).status() == ParseInfo::E::SUCCESS;
+      pos += sz;
+    }
+    return n;
+  }
+} // namespace
+
+int main()
+{
+  std::vector<MidiEvent> events(kMessages);
+  const double m = kMessages / 1e6;
+
+  const std::vector<std::uint8_t> plain = corpus(false);
+  bench::report("scalar Insight + Interpret loop", bench::best([&] { bench::keep(scalarLoop(plain.data(), plain.size(), events.data())); }), m, "M msg/s");
+  bench::report("InterpretBatch", bench::best([&] { bench::keep(MidiBytes::InterpretBatch(plain.data(), plain.size(), events.data(), events.size())); }), m, "M msg/s");
+
+  const std::vector<std::uint8_t> running = corpus(true);
+  bench::report("InterpretBatch, running status", bench::best([&] { bench::keep(MidiBytes::InterpretBatch(running.data(), running.size(), events.data(), events.size())); }), m, "M msg/s");
+
+  // Ingest in 4 KiB reads, the running status carried from one call to the next
+  bench::report("InterpretBatch, running status, 4 KiB reads", bench::best([&] {
+                  std::uint8_t status = 0;
+                  std::size_t pos = 0;
+                  std::size_t n = 0;
+                  while (pos < running.size())
+                  {
+                    const std::size_t end = running.size() - pos < 4096 ? running.size() : pos + 4096;
+                    const BatchInfo r = MidiBytes::InterpretBatch(running.data() + pos, end - pos, events.data() + n, events.size() - n, status);
+                    pos += r.consumed, n += r.produced;
+                    if (end == running.size() && !r.consumed)
+                      break;
+                  }
+                  bench::keep(n);
+                }),
+                m, "M msg/s");
+
+  const std::vector<std::uint32_t> ump = words();
+  const double mw = ump.size() / 1e6;
+  bench::report("packet by packet M2::method loop", bench::best([&] { bench::keep(packetLoop(ump.data(), ump.size(), events.data())); }), mw, "M words/s");
+  bench::report("InterpretWords", bench::best([&] { bench::keep(MidiBytes::InterpretWords(ump.data(), ump.size(), events.data(), events.size())); }), mw, "M words/s");
+  return 0;
+}
@@ -0,0 +1,66 @@
+/**
+ * @file midi_encode.cpp
+ * @author Etienne SANTOUL github.com/esantoul
+ * @brief Encoding throughput in messages/second: MidiEncoder with & without running status, UmpEncoder with MIDI 1.0 &
+ * MIDI 2.0 channel voice packets
+ * @version 0.1
+ * @date 2021-02-04
+ *
+ * @copyright BSD 2-Clause License. Copyright (c) 2021, Etienne SANTOUL. All rights reserved.
+ */
+
+#include "bench.hpp"
+#include "midi_encode.hpp"
+#include "../src/midi_parser.cpp.template"
+#include <cstdint>
+#include <vector>
+
+namespace
+{
+  constexpr std::size_t kMessages = 1 << 20;
+
+  // Channel voice events over 4 channels with a timing clock every 64 events
+  std::vector<MidiEvent> events(std::uint8_t protocol)
+  {
+    constexpr EventType types[] = {EventType::NoteOn, EventType::NoteOff, EventType::ControlChange, EventType::PitchBend,
+                                   EventType::ChannelPressure, EventType::ProgramChange};
+    bench::Rng rng{0x2021};
+    std::vector<MidiEvent> e(kMessages);
+    for (std::size_t i = 0; i < kMessages; ++i)
+    {
+      e[i] = MidiEvent{i % 64 ? types[rng() % 6] : EventType::TimingClock, 1, std::uint8_t(rng() % 4), std::uint8_t(rng() % 4), std::uint8_t(rng() & 0x7F)};
+      e[i].protocol = e[i].type == EventType::TimingClock ? 1 : protocol;
+      e[i].value = protocol == 2 ? rng() : rng() & 0x3FFF;
+      e[i].data16 = static_cast<std::uint16_t>(rng());
+    }
+    return e;
+  }
+} // namespace
+
+int main()
+{
+  const double m = kMessages / 1e6;
+  const std::vector<MidiEvent> m1 = events(1);
+  const std::vector<MidiEvent> m2 = events(2);
+
+  std::vector<std::uint8_t> bytes(3 * kMessages);
+  for (bool runningStatus : {false, true})
+    bench::report(runningStatus ? "MidiEncoder, running status" : "MidiEncoder", bench::best([&] {
+                    MidiEncoder encoder{bytes.data(), bytes.size(), runningStatus};
+                    for (const MidiEvent &e : m1)
+                      encoder.append(e);
+                    bench::keep(encoder.size());
+                  }),
+                  m, "M msg/s");
+
+  std::vector<std::uint32_t> words(2 * kMessages);
+  for (const auto *corpus : {&m1, &m2})
+    bench::report(corpus == &m1 ? "UmpEncoder, MIDI 1.0 channel voice" : "UmpEncoder, MIDI 2.0 channel voice", bench::best([&] {
+                    UmpEncoder encoder{words.data(), words.size()};
+                    for (const MidiEvent &e : *corpus)
+                      encoder.append(e);
+                    bench::keep(encoder.size());
+                  }),
+                  m, "M msg/s");
+  return 0;
+}
@@ -0,0 +1,110 @@
+/**
+ * @file sample_dump.cpp
+ * @author Etienne SANTOUL github.com/esantoul
+ * @brief Sample Dump Standard throughput in MB/s of input: the unpack & checksum kernels over a 64 MB buffer, and the
+ * whole decoder over a 64 MB dump of 120-byte packets fed as raw bytes & as SysExView, against memcpy as the memory
+ * bandwidth reference
+ * @version 0.1
+ * @date 2021-02-04
+ *
+ * @copyright BSD 2-Clause License. Copyright (c) 2021, Etienne SANTOUL. All rights reserved.
+ */
+
+#include "bench.hpp"
+#include "sample_dump.hpp"
+#include "../src/midi_parser.cpp.template"
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+  constexpr std::size_t kBytes = 64 << 20;
+
+  // F0 7E 00 01 ... F7 header of a dump of `length` samples
+  std::vector<std::uint8_t> header(std::uint8_t bits, std::uint32_t length)
+  {
+    return {0xF0, 0x7E, 0x00, 0x01, 0x00, 0x00, bits, 0x00, 0x00, 0x01, std::uint8_t(length & 0x7F), std::uint8_t(length >> 7 & 0x7F),
+            std::uint8_t(length >> 14 & 0x7F), 0, 0, 0, 0, 0, 0, 0x7F, 0xF7};
+  }
+
+  // Data packets F0 7E 00 02 kk <120 bytes> ll F7, back to back
+  std::vector<std::uint8_t> packets(std::size_t count)
+  {
+    bench::Rng rng{0x2021};
+    std::vector<std::uint8_t> bytes(127 * count);
+    for (std::size_t k = 0; k < count; ++k)
+    {
+      std::uint8_t *p = bytes.data() + 127 * k;
+      p[0] = 0xF0, p[1] = 0x7E, p[2] = 0x00, p[3] = 0x02, p[4] = k & 0x7F;
+      for (std::size_t i = 5; i < 125; ++i)
+        p[i] = rng() & 0x7F;
+      p[125] = SdsUnpack::checksum(p + 1, 124) & 0x7F;
+      p[126] = 0xF7;
+    }
+    return bytes;
+  }
+} // namespace
+
+int main()
+{
+  const double mb = kBytes / 1e6;
+  std::vector<std::uint8_t> in(kBytes);
+  bench::Rng rng{0x2021};
+  for (auto &b : in)
+    b = rng() & 0x7F;
+  std::vector<std::uint8_t> copy(kBytes);
+  std::vector<std::int32_t> samples(kBytes / 2);
+
+  bench::report("memcpy (bandwidth reference)", bench::best([&] { std::memcpy(copy.data(), in.data(), kBytes); bench::keep(copy[0]); }), mb, "MB/s");
+  bench::report("SdsUnpack::checksum", bench::best([&] { bench::keep(SdsUnpack::checksum(in.data(), kBytes)); }), mb, "MB/s");
+  bench::report("SdsUnpack::checksum, 124-byte packets", bench::best([&] {
+                  std::uint8_t x = 0;
+                  for (std::size_t k = 0; k + 124 <= kBytes; k += 127)
+                    x ^= SdsUnpack::checksum(in.data() + k, 124);
+                  bench::keep(x);
+                }),
+                mb, "MB/s");
+  // 2, 3 & 4 bytes per sample
+  for (std::uint8_t bits : {14, 16, 28})
+  {
+    const std::size_t n = (bits + 6u) / 7u;
+    char name[64];
+    std::snprintf(name, sizeof name, "SdsUnpack::unpack, %u-bit", bits);
+    bench::report(name, bench::best([&] { SdsUnpack::unpack(in.data(), kBytes, bits, samples.data(), kBytes / n); bench::keep(samples[0]); }), mb, "MB/s");
+  }
+
+  // Whole decoder: validation, checksum & unpacking of each packet, in one read from raw bytes, after the SysExView::parse
+  // scan otherwise. Dump lengths are 21-bit sample counts, the packets are sent as dumps of 16384 packets
+  constexpr std::size_t perDump = 16384;
+  const std::size_t count = kBytes / 127 / perDump * perDump;
+  const std::vector<std::uint8_t> dump = packets(count);
+  for (std::uint8_t bits : {16, 28})
+    for (bool raw : {true, false})
+    {
+      const std::size_t n = (bits + 6u) / 7u;
+      const std::vector<std::uint8_t> h = header(bits, static_cast<std::uint32_t>(perDump * (120 / n)));
+      SampleDumpDecoder decoder{samples.data(), samples.size()};
+      std::size_t received = 0;
+      char name[64];
+      std::snprintf(name, sizeof name, raw ? "SampleDumpDecoder, %u-bit packets" : "SampleDumpDecoder, %u-bit, SysExView", bits);
+      bench::report(name, bench::best([&] {
+                      received = 0;
+                      decoder.reset();
+                      for (std::size_t k = 0; k < count; ++k)
+                      {
+                        if (k % perDump == 0)
+                          received += decoder.received(), decoder.feed(h.data(), h.size());
+                        const std::uint8_t *p = dump.data() + 127 * k;
+                        raw ? decoder.feed(p, 127) : decoder.feed(SysExView::parse(p, 127));
+                      }
+                      received += decoder.received();
+                      bench::keep(received);
+                    }),
+                    dump.size() / 1e6, "MB/s");
+      if (received != count * (120 / n))
+        std::fprintf(stderr, "decoder stopped after %zu samples\n", received);
+    }
+  return 0;
+}
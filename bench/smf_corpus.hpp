@@ -0,0 +1,153 @@
+#ifndef SMF_CORPUS_HPP
+#define SMF_CORPUS_HPP
+
+/**
+ * @file smf_corpus.hpp
+ * @author Etienne SANTOUL github.com/esantoul
+ * @brief Standard MIDI File corpus for the SMF benchmarks: the files given on the command line, or generated files
+ * @version 0.1
+ * @date 2021-02-04
+ *
+ * @copyright BSD 2-Clause License. Copyright (c) 2021, Etienne SANTOUL. All rights reserved.
+ */
+
+#include "bench.hpp"
+#include "smf_writer.hpp"
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+namespace bench
+{
+  /**
+   * @brief Format 1 file of `tracks` tracks holding about `bytes` bytes of notes, controllers, pitch bends & the odd
+   * SysEx, written with running status
+   */
+  inline std::vector<std::uint8_t> smfFile(std::uint32_t seed, std::uint16_t tracks, std::size_t bytes)
+  {
+    Rng rng{seed};
+    SmfVectorSink sink{bytes + 1024};
+    SmfWriter<SmfVectorSink> writer{sink};
+    writer.header(1, tracks, 480);
+    for (std::uint16_t t = 0; t < tracks; ++t)
+    {
+      writer.beginTrack();
+      if (!t)
+        writer.tempo(0, 500000);
+      const std::uint8_t ch = static_cast<std::uint8_t>(t & 0x0F);
+      const std::size_t end = (t + 1) * bytes / tracks;
+      while (sink.offset() < end)
+      {
+        const std::uint32_t r = rng();
+        const std::uint32_t delta = r >> 28;
+        switch (r & 0x0F)
+        {
+        case 0:
+        case 1:
+        {
+          const std::uint8_t m[3] = {std::uint8_t(0xB0 | ch), std::uint8_t(r >> 8 & 0x7F), std::uint8_t(r >> 16 & 0x7F)};
+          writer.message(delta, m, 3);
+          break;
+        }
+        case 2:
+        {
+          const std::uint8_t m[3] = {std::uint8_t(0xE0 | ch), std::uint8_t(r >> 8 & 0x7F), std::uint8_t(r >> 16 & 0x7F)};
+          writer.message(delta, m, 3);
+          break;
+        }
+        case 3:
+          if (!(r & 0x0F00))
+          {
+            const std::uint8_t body[8] = {0x7D, 1, 2, 3, 4, 5, 6, 0xF7};
+            writer.sysex(delta, body, sizeof body);
+            break;
+          }
+          [[fallthrough]];
+        default:
+        {
+          const std::uint8_t m[3] = {std::uint8_t(0x90 | ch), std::uint8_t(r >> 8 & 0x7F), std::uint8_t(r >> 16 & 0x7F)};
+          writer.message(delta, m, 3);
+          break;
+        }
+        }
+      }
+      writer.endTrack();
+    }
+    return std::move(sink.bytes());
+  }
+
+  /**
+   * @brief The files given on the command line, or generated files written to a temporary directory removed on destruction
+   */
+  class SmfCorpus
+  {
+  public:
+    SmfCorpus(int argc, char **argv, std::size_t files, std::uint16_t tracks, std::size_t fileBytes)
+    {
+      for (int i = 1; i < argc; ++i)
+        add(argv[i]);
+      if (!mPaths.empty())
+        return;
+
+      char dir[] = "/tmp/midi_bench_XXXXXX";
+      if (!::mkdtemp(dir))
+        return;
+      mDir = dir;
+      for (std::size_t i = 0; i < files; ++i)
+      {
+        const std::vector<std::uint8_t> data = smfFile(static_cast<std::uint32_t>(0x2021 + i), tracks, fileBytes);
+        const std::string path = mDir + "/" + std::to_string(i) + ".mid";
+        if (std::FILE *f = std::fopen(path.c_str(), "wb"))
+        {
+          std::fwrite(data.data(), 1, data.size(), f);
+          std::fclose(f);
+          mGenerated.push_back(path);
+          add(path);
+        }
+      }
+    }
+
+    SmfCorpus(const SmfCorpus &) = delete;
+    SmfCorpus &operator=(const SmfCorpus &) = delete;
+
+    ~SmfCorpus()
+    {
+      for (const std::string &p : mGenerated)
+        std::remove(p.c_str());
+      if (!mDir.empty())
+        ::rmdir(mDir.c_str());
+    }
+
+    const std::vector<std::string> &paths() const { return mPaths; }
+    std::vector<const char *> cpaths() const
+    {
+      std::vector<const char *> out;
+      for (const std::string &p : mPaths)
+        out.push_back(p.c_str());
+      return out;
+    }
+    // Total size in MB
+    double megabytes() const { return mBytes / 1e6; }
+
+  private:
+    void add(const std::string &path)
+    {
+      if (std::FILE *f = std::fopen(path.c_str(), "rb"))
+      {
+        std::fseek(f, 0, SEEK_END);
+        mBytes += static_cast<double>(std::ftell(f));
+        std::fclose(f);
+        mPaths.push_back(path);
+      }
+    }
+
+    std::string mDir;
+    std::vector<std::string> mGenerated;
+    std::vector<std::string> mPaths;
+    double mBytes{};
+  };
+} // namespace bench
+
+#endif // SMF_CORPUS_HPP
@@ -0,0 +1,65 @@
+/**
+ * @file smf_parallel.cpp
+ * @author Etienne SANTOUL github.com/esantoul
+ * @brief Parallel SMF decoding scaling with the number of worker threads: a file with many tracks (decode & merge) and a
+ * batch of files. Usage: smf_parallel [file.mid ...], the batch is generated without arguments
+ * @version 0.1
+ * @date 2021-02-04
+ *
+ * @copyright BSD 2-Clause License. Copyright (c) 2021, Etienne SANTOUL. All rights reserved.
+ */
+
+#include "bench.hpp"
+#include "smf_corpus.hpp"
+#include "smf_parallel.hpp"
+#include "../src/midi_parser.cpp.template"
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+int main(int argc, char **argv)
+{
+  const unsigned cores = std::thread::hardware_concurrency() ? std::thread::hardware_concurrency() : 1;
+  std::vector<unsigned> threads;
+  for (unsigned t = 1; t < 2 * cores || t <= 4; t *= 2)
+    threads.push_back(t);
+  std::printf("%u hardware threads\n", cores);
+
+  // One 64-track file of 8 MB, decoded track by track & merged
+  const std::vector<std::uint8_t> data = bench::smfFile(0x2021, 64, 8 << 20);
+  auto file = std::make_unique<SmfFile<>>();
+  if (file->parse(data.data(), data.size()).status() != SMF_STATUS::SUCCESS)
+    return 1;
+  std::vector<SmfEvent> events;
+  double base = 0;
+  for (unsigned t : threads)
+  {
+    const double s = bench::best([&] { bench::keep(SmfParallel::decode(*file, events, t)); });
+    base = base ? base : s;
+    char name[64];
+    std::snprintf(name, sizeof name, "decode, 64 tracks, %2u threads (x%.2f)", t, base / s);
+    bench::report(name, s, data.size() / 1e6, "MB/s");
+  }
+
+  // Batch of files, one file per worker at a time
+  const bench::SmfCorpus corpus{argc, argv, 64, 16, 1 << 20};
+  const std::vector<const char *> paths = corpus.cpaths();
+  base = 0;
+  for (unsigned t : threads)
+  {
+    const double s = bench::best([&] {
+      std::atomic<std::size_t> n{0};
+      SmfParallel::decodeFiles(paths.data(), paths.size(), [&](std::size_t, SmfInfo, const std::vector<SmfEvent> &ev) { n += ev.size(); }, t);
+      bench::keep(n);
+    });
+    base = base ? base : s;
+    char name[64];
+    std::snprintf(name, sizeof name, "decodeFiles, %zu files, %2u threads (x%.2f)", paths.size(), t, base / s);
+    bench::report(name, s, corpus.megabytes(), "MB/s");
+  }
+  return 0;
+}
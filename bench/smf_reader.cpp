@@ -0,0 +1,81 @@
+/**
+ * @file smf_reader.cpp
+ * @author Etienne SANTOUL github.com/esantoul
+ * @brief Standard MIDI File reader throughput in MB/s: mapping, chunk walk & event decoding of every track.
+ * Usage: smf_reader [file.mid ...], a generated 64 MB corpus without arguments
+ * @version 0.1
+ * @date 2021-02-04
+ *
+ * @copyright BSD 2-Clause License. Copyright (c) 2021, Etienne SANTOUL. All rights reserved.
+ */
+
+#include "bench.hpp"
+#include "smf_corpus.hpp"
+#include "smf_reader.hpp"
+#include "../src/midi_parser.cpp.template"
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace
+{
+  // Events of every track, 0 if a track fails
+  template <std::size_t max_tracks>
+  std::size_t decodeAll(const SmfFile<max_tracks> &file)
+  {
+    std::size_t n = 0;
+    for (std::size_t t = 0; t < file.tracks(); ++t)
+    {
+      SmfTrack::Cursor cursor{file.track(t)};
+      SmfEvent e;
+      SmfInfo ret;
+      while ((ret = cursor.next(e)).status() == SMF_STATUS::SUCCESS)
+        n += e.event.type != EventType::None;
+      if (ret)
+        return 0;
+    }
+    return n;
+  }
+} // namespace
+
+int main(int argc, char **argv)
+{
+  const bench::SmfCorpus corpus{argc, argv, 64, 16, 1 << 20};
+  if (corpus.paths().empty())
+  {
+    std::fprintf(stderr, "no readable file\n");
+    return 1;
+  }
+  auto file = std::make_unique<SmfFile<>>();
+  std::size_t events = 0;
+  for (const std::string &p : corpus.paths())
+    if (file->open(p.c_str()).status() == SMF_STATUS::SUCCESS)
+      events += decodeAll(*file);
+  std::printf("%zu files, %.1f MB, %zu decoded events\n", corpus.paths().size(), corpus.megabytes(), events);
+
+  bench::report("SmfFile::open + Cursor, every track", bench::best([&] {
+                  std::size_t n = 0;
+                  for (const std::string &p : corpus.paths())
+                    if (file->open(p.c_str()).status() == SMF_STATUS::SUCCESS)
+                      n += decodeAll(*file);
+                  bench::keep(n);
+                }),
+                corpus.megabytes(), "MB/s");
+
+  // Same decoding over files already in memory, without the mapping cost
+  std::vector<std::vector<std::uint8_t>> loaded;
+  for (const std::string &p : corpus.paths())
+    if (MappedFile m; m.open(p.c_str()))
+      loaded.emplace_back(m.data(), m.data() + m.size());
+  bench::report("SmfFile::parse + Cursor, in memory", bench::best([&] {
+                  std::size_t n = 0;
+                  for (const std::vector<std::uint8_t> &d : loaded)
+                    if (file->parse(d.data(), d.size()).status() == SMF_STATUS::SUCCESS)
+                      n += decodeAll(*file);
+                  bench::keep(n);
+                }),
+                corpus.megabytes(), "MB/s");
+  return 0;
+}
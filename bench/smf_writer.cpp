@@ -0,0 +1,97 @@
+/**
+ * @file smf_writer.cpp
+ * @author Etienne SANTOUL github.com/esantoul
+ * @brief Standard MIDI File writer throughput in events/second: a 16 track file of decoded MIDI 1.0 events written
+ * through a preallocated buffer & through a file descriptor
+ * @version 0.1
+ * @date 2021-02-04
+ *
+ * @copyright BSD 2-Clause License. Copyright (c) 2021, Etienne SANTOUL. All rights reserved.
+ */
+
+#include "bench.hpp"
+#include "smf_writer.hpp"
+#include "../src/midi_parser.cpp.template"
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <unistd.h>
+#include <vector>
+
+namespace
+{
+  constexpr std::size_t kEvents = 1 << 22;
+  constexpr std::uint16_t kTracks = 16;
+
+  // Channel voice events, a SysEx of up to 48 bytes every 256
+  std::vector<MidiEvent> events(const std::vector<std::uint8_t> &sysex)
+  {
+    constexpr EventType voice[] = {EventType::NoteOn, EventType::NoteOn, EventType::NoteOff, EventType::ControlChange,
+                                   EventType::PitchBend, EventType::ProgramChange};
+    bench::Rng rng{0x2021};
+    std::vector<MidiEvent> e(kEvents);
+    for (std::size_t i = 0; i < kEvents; ++i)
+    {
+      e[i] = MidiEvent{i % 256 ? voice[rng() % 6] : EventType::SysEx, 1, 0, std::uint8_t(rng() % 2), std::uint8_t(rng() & 0x7F)};
+      e[i].value = rng() & 0x3FFF;
+      if (e[i].type == EventType::SysEx)
+        e[i].payload = sysex.data(), e[i].length = rng() % 49;
+    }
+    return e;
+  }
+
+  // Format 1 file, the events split evenly over the tracks with deltas of 0 to 15 ticks
+  template <typename Sink_t>
+  bool write(Sink_t &sink, const std::vector<MidiEvent> &e)
+  {
+    SmfWriter<Sink_t> writer{sink};
+    writer.header(1, kTracks, 480);
+    for (std::size_t t = 0; t < kTracks; ++t)
+    {
+      writer.beginTrack();
+      for (std::size_t i = t * kEvents / kTracks; i < (t + 1) * kEvents / kTracks; ++i)
+        writer.event(static_cast<std::uint32_t>(i & 0x0F), e[i]);
+      writer.endTrack();
+    }
+    return writer.ok();
+  }
+} // namespace
+
+int main()
+{
+  std::vector<std::uint8_t> sysex(48);
+  bench::Rng rng{0x7F};
+  for (auto &b : sysex)
+    b = rng() & 0x7F;
+  const std::vector<MidiEvent> corpus = events(sysex);
+  const double m = kEvents / 1e6;
+
+  // Worst case: 4 bytes of delta & 3 bytes of message, or the whole SysEx
+  std::vector<std::uint8_t> buffer(64 * kEvents);
+  SmfBufferSink check{buffer.data(), buffer.size()};
+  if (!write(check, corpus))
+    std::fprintf(stderr, "buffer overflow\n");
+  bench::report("SmfWriter, SmfBufferSink", bench::best([&] {
+                  SmfBufferSink sink{buffer.data(), buffer.size()};
+                  bench::keep(write(sink, corpus));
+                }),
+                m, "M events/s");
+
+  char path[] = "/tmp/midi_bench_XXXXXX";
+  const int fd = ::mkstemp(path);
+  if (fd < 0)
+  {
+    std::fprintf(stderr, "no temporary file\n");
+    return 1;
+  }
+  ::unlink(path);
+  bench::report("SmfWriter, SmfFdSink", bench::best([&] {
+                  ::lseek(fd, 0, SEEK_SET);
+                  SmfFdSink<> sink{fd};
+                  if (!write(sink, corpus))
+                    std::fprintf(stderr, "write error\n");
+                }),
+                m, "M events/s");
+  ::close(fd);
+  return 0;
+}
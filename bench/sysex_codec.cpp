@@ -0,0 +1,58 @@
+/**
+ * @file sysex_codec.cpp
+ * @author Etienne SANTOUL github.com/esantoul
+ * @brief SysEx codec throughput in MB/s of input: 8-into-7 packing & nibblized encoding of a 64 MB dump, into a
+ * separate buffer & in place, against memcpy as the memory bandwidth reference
+ * @version 0.1
+ * @date 2021-02-04
+ *
+ * @copyright BSD 2-Clause License. Copyright (c) 2021, Etienne SANTOUL. All rights reserved.
+ */
+
+#include "bench.hpp"
+#include "sysex_codec.hpp"
+#include "../src/midi_parser.cpp.template"
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+  constexpr std::size_t kBytes = 64 << 20;
+} // namespace
+
+int main()
+{
+  std::vector<std::uint8_t> data(kBytes);
+  bench::Rng rng{0x2021};
+  for (auto &b : data)
+    b = static_cast<std::uint8_t>(rng());
+  std::vector<std::uint8_t> copy(kBytes);
+  bench::report("memcpy (bandwidth reference)", bench::best([&] { std::memcpy(copy.data(), data.data(), kBytes); bench::keep(copy[0]); }), kBytes / 1e6, "MB/s");
+
+  // 8-into-7, the decoders read what the encoders wrote
+  const std::size_t packedBytes = SysExCodec::packedSize(kBytes);
+  std::vector<std::uint8_t> packed(packedBytes);
+  std::vector<std::uint8_t> work(packedBytes);
+  bench::report("SysExCodec::pack", bench::best([&] { bench::keep(SysExCodec::pack(data.data(), kBytes, packed.data())); }), kBytes / 1e6, "MB/s");
+  bench::report("SysExCodec::unpack", bench::best([&] { bench::keep(SysExCodec::unpack(packed.data(), packedBytes, copy.data())); }), packedBytes / 1e6, "MB/s");
+  // In place, each run codes what the previous one left: the kernels do not depend on the values
+  std::memcpy(work.data(), data.data(), kBytes);
+  bench::report("SysExCodec::pack, in place", bench::best([&] { bench::keep(SysExCodec::pack(work.data(), kBytes, work.data())); }), kBytes / 1e6, "MB/s");
+  bench::report("SysExCodec::unpack, in place", bench::best([&] { bench::keep(SysExCodec::unpack(work.data(), packedBytes, work.data())); }), packedBytes / 1e6, "MB/s");
+
+  // Nibblized
+  const std::size_t nibbleBytes = SysExCodec::nibblizedSize(kBytes);
+  std::vector<std::uint8_t> nibbles(nibbleBytes);
+  work.assign(nibbleBytes, 0);
+  bench::report("SysExCodec::nibblize", bench::best([&] { bench::keep(SysExCodec::nibblize(data.data(), kBytes, nibbles.data())); }), kBytes / 1e6, "MB/s");
+  bench::report("SysExCodec::denibblize", bench::best([&] { bench::keep(SysExCodec::denibblize(nibbles.data(), nibbleBytes, copy.data())); }), nibbleBytes / 1e6, "MB/s");
+  std::memcpy(work.data(), data.data(), kBytes);
+  bench::report("SysExCodec::nibblize, in place", bench::best([&] { bench::keep(SysExCodec::nibblize(work.data(), kBytes, work.data())); }), kBytes / 1e6, "MB/s");
+  bench::report("SysExCodec::denibblize, in place", bench::best([&] { bench::keep(SysExCodec::denibblize(work.data(), nibbleBytes, work.data())); }), nibbleBytes / 1e6, "MB/s");
+
+  if (std::memcmp(copy.data(), data.data(), kBytes) != 0)
+    std::fprintf(stderr, "codec round trip mismatch\n");
+  return 0;
+}
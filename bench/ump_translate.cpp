@@ -0,0 +1,76 @@
+/**
+ * @file ump_translate.cpp
+ * @author Etienne SANTOUL github.com/esantoul
+ * @brief UmpTranslator throughput in packets/second over MIDI 1.0 channel voice, system & SysEx events, translated as a
+ * batch & one event at a time
+ * @version 0.1
+ * @date 2021-02-04
+ *
+ * @copyright BSD 2-Clause License. Copyright (c) 2021, Etienne SANTOUL. All rights reserved.
+ */
+
+#include "bench.hpp"
+#include "ump_stream.hpp"
+#include "ump_translate.hpp"
+#include "../src/midi_parser.cpp.template"
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+namespace
+{
+  constexpr std::size_t kEvents = 1 << 20;
+
+  // Channel voice events over 4 channels, a system common or realtime event every 8 & a SysEx of up to 48 bytes every 64
+  std::vector<MidiEvent> events(const std::vector<std::uint8_t> &sysex)
+  {
+    constexpr EventType voice[] = {EventType::NoteOn, EventType::NoteOff, EventType::ControlChange, EventType::PitchBend,
+                                   EventType::ChannelPressure, EventType::ProgramChange};
+    constexpr EventType system[] = {EventType::TimingClock, EventType::MTC, EventType::SongPos, EventType::ActiveSensing};
+    bench::Rng rng{0x2021};
+    std::vector<MidiEvent> e(kEvents);
+    for (std::size_t i = 0; i < kEvents; ++i)
+    {
+      const EventType t = i % 64 == 0 ? EventType::SysEx : i % 8 == 0 ? system[rng() % 4] : voice[rng() % 6];
+      e[i] = MidiEvent{t, 1, 0, std::uint8_t(rng() % 4), std::uint8_t(rng() & 0x7F)};
+      e[i].value = rng() & 0x3FFF;
+      if (t == EventType::SysEx)
+        e[i].payload = sysex.data(), e[i].length = rng() % 49;
+    }
+    return e;
+  }
+} // namespace
+
+int main()
+{
+  std::vector<std::uint8_t> sysex(48);
+  bench::Rng rng{0x7F};
+  for (auto &b : sysex)
+    b = rng() & 0x7F;
+  const std::vector<MidiEvent> corpus = events(sysex);
+
+  std::size_t size = 0;
+  for (const MidiEvent &e : corpus)
+    size += UmpTranslator<>::size(e);
+  std::vector<std::uint32_t> words(size);
+  UmpTranslator<> translator;
+  translator.setGroup(0, 3);
+
+  const BatchInfo r = translator.translate(corpus.data(), corpus.size(), 0, words.data(), words.size());
+  std::size_t packets = 0;
+  for (std::size_t pos = 0; pos < r.produced; pos += UmpFraming::packetWords(words[pos]))
+    ++packets;
+  if (r.consumed != corpus.size() || r.produced != size)
+    std::fprintf(stderr, "translation stopped early\n");
+
+  const double p = packets / 1e6;
+  bench::report("UmpTranslator, batch", bench::best([&] { bench::keep(translator.translate(corpus.data(), corpus.size(), 0, words.data(), words.size())); }), p, "M packets/s");
+  bench::report("UmpTranslator, one event at a time", bench::best([&] {
+                  std::size_t n = 0;
+                  for (const MidiEvent &e : corpus)
+                    n += UmpTranslator<>::translate(e, 3, words.data() + n, words.size() - n);
+                  bench::keep(n);
+                }),
+                p, "M packets/s");
+  return 0;
+}
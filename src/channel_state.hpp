@@ -0,0 +1,136 @@
+#ifndef CHANNEL_STATE_HPP
+#define CHANNEL_STATE_HPP
+
+/**
+ * @file channel_state.hpp
+ * @author Etienne SANTOUL github.com/esantoul
+ * @brief Current controller, program, pressure, pitch bend & held note state of MIDI channels
+ * @version 0.1
+ * @date 2021-02-04
+ *
+ * @copyright BSD 2-Clause License. Copyright (c) 2021, Etienne SANTOUL. All rights reserved.
+ */
+
+#include "midi_event.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+/**
+ * @brief State of one channel at MIDI 1.0 resolution, 5 cache lines
+ */
+struct alignas(64) ChannelState
+{
+  std::uint8_t cc[128];
+  std::uint8_t polyPressure[128]; // last key pressure of each note
+  std::uint64_t notes[2];         // held notes, bit n % 64 of word n / 64
+  std::uint16_t bend;             // 14 bits, 8192 is the center
+  std::uint8_t program;
+  std::uint8_t pressure;
+
+  constexpr bool held(std::uint8_t note) const { return notes[note >> 6 & 1] >> (note & 63) & 1; }
+  constexpr std::size_t heldCount() const { return std::size_t(__builtin_popcountll(notes[0]) + __builtin_popcountll(notes[1])); }
+  constexpr std::uint16_t bank() const { return std::uint16_t(cc[0] << 7 | cc[32]); }
+  constexpr std::int16_t bendOffset() const { return std::int16_t(bend - 8192); }
+
+  constexpr void reset()
+  {
+    *this = ChannelState{};
+    bend = 8192;
+  }
+};
+
+static_assert(sizeof(ChannelState) == 320, "ChannelState must span 5 cache lines");
+
+/**
+ * @brief Channel state of many ports in one contiguous, cache line aligned arena allocated at construction.
+ * MIDI 2.0 values (protocol 2) are stored at MIDI 1.0 resolution. All queries are direct array accesses.
+ */
+class ChannelTracker
+{
+public:
+  static constexpr std::size_t channels = 16;
+
+  explicit ChannelTracker(std::size_t ports) : mPorts{ports}, mStates{new ChannelState[ports * channels]}
+  {
+    for (std::size_t i = 0; i < ports * channels; ++i)
+      mStates[i].reset();
+  }
+
+  /**
+   * @brief Applies a decoded channel voice event
+   * @param port port index (map UMP groups to ports as needed, the event group is ignored)
+   * @return true if the event changed the channel state
+   */
+  bool update(std::size_t port, const MidiEvent &e)
+  {
+    ChannelState &s = mStates[port * channels + (e.channel & 0x0F)];
+    const bool m2 = e.protocol == 2;
+    switch (e.type)
+    {
+    case EventType::NoteOn:
+    case EventType::NoteOff:
+    {
+      // MIDI 1.0 note on with velocity 0 is a note off, MIDI 2.0 velocity 0 is a note on
+      const std::uint64_t on = e.type == EventType::NoteOn && (m2 || e.value);
+      const std::uint64_t bit = std::uint64_t{1} << (e.data1 & 63);
+      std::uint64_t &w = s.notes[e.data1 >> 6 & 1];
+      w = (w & ~bit) | (bit & (std::uint64_t{0} - on));
+      return true;
+    }
+    case EventType::PolyPressure:
+      s.polyPressure[e.data1 & 0x7F] = static_cast<std::uint8_t>(m2 ? e.value >> 25 : e.value);
+      return true;
+    case EventType::ControlChange:
+      s.cc[e.data1 & 0x7F] = static_cast<std::uint8_t>(m2 ? e.value >> 25 : e.value);
+      // All Sound Off & All Notes Off release every note
+      if (e.data1 == 120 || e.data1 == 123)
+        s.notes[0] = s.notes[1] = 0;
+      return true;
+    case EventType::ProgramChange:
+      s.program = e.data1 & 0x7F;
+      if (m2 && (e.data2 & 1)) // bank valid
+        s.cc[0] = e.data16 >> 7 & 0x7F, s.cc[32] = e.data16 & 0x7F;
+      return true;
+    case EventType::ChannelPressure:
+      s.pressure = static_cast<std::uint8_t>(m2 ? e.value >> 25 : e.value);
+      return true;
+    case EventType::PitchBend:
+      s.bend = static_cast<std::uint16_t>(m2 ? e.value >> 18 : e.value);
+      return true;
+    default:
+      return false;
+    }
+  }
+
+  /**
+   * @brief Applies a batch of decoded events of the same port
+   * @return the number of events that changed the state
+   */
+  std::size_t update(std::size_t port, const MidiEvent *events, std::size_t count)
+  {
+    std::size_t n = 0;
+    for (std::size_t i = 0; i < count; ++i)
+      n += update(port, events[i]);
+    return n;
+  }
+
+  const ChannelState &channel(std::size_t port, std::uint8_t channel) const { return mStates[port * channels + (channel & 0x0F)]; }
+
+  std::uint8_t cc(std::size_t port, std::uint8_t channel, std::uint8_t controller) const { return this->channel(port, channel).cc[controller & 0x7F]; }
+  bool held(std::size_t port, std::uint8_t channel, std::uint8_t note) const { return this->channel(port, channel).held(note & 0x7F); }
+
+  void reset(std::size_t port)
+  {
+    for (std::size_t c = 0; c < channels; ++c)
+      mStates[port * channels + c].reset();
+  }
+
+  std::size_t ports() const { return mPorts; }
+
+private:
+  std::size_t mPorts;
+  std::unique_ptr<ChannelState[]> mStates;
+};
+
+#endif // CHANNEL_STATE_HPP
@@ -0,0 +1,316 @@
+#ifndef CLIP_FILE_HPP
+#define CLIP_FILE_HPP
+
+/**
+ * @file clip_file.hpp
+ * @author Etienne SANTOUL github.com/esantoul
+ * @brief MIDI Clip File (SMF2CLIP) reader & writer
+ * @version 0.1
+ * @date 2021-02-04
+ *
+ * @copyright BSD 2-Clause License. Copyright (c) 2021, Etienne SANTOUL. All rights reserved.
+ */
+
+#include "midi_encode.hpp"
+#include "smf_reader.hpp"
+#include "ump_stream.hpp"
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief MIDI Clip File layout: the "SMF2CLIP" signature followed by big-endian UMP words.
+ * The clip header (Delta Clockstamp Ticks Per Quarter Note & configuration messages) ends with a Start of Clip
+ * message, the clip sequence follows, each message preceded by a Delta Clockstamp, up to End of Clip.
+ */
+struct ClipFormat : NotInstantiable
+{
+  static constexpr char signature[9] = "SMF2CLIP";
+  static constexpr std::size_t signatureSize = 8;
+
+  // UMP Stream messages (message type 0xF, 128 bits) delimiting the clip sequence
+  static constexpr std::uint32_t StartOfClip = 0xF0200000;
+  static constexpr std::uint32_t EndOfClip = 0xF0210000;
+  static constexpr std::uint32_t StreamStatusMask = 0xF3FF0000;
+};
+
+/**
+ * @brief A packet of a clip, `packet` points to its big-endian words in the file
+ */
+struct ClipEvent
+{
+  std::uint64_t tick{}; // absolute time in Delta Clockstamp ticks
+  const std::uint8_t *packet{};
+  std::uint8_t words{};
+  MidiEvent event{}; // decoded by MidiBytes::M2::method, type None for message types outside of the MidiBytes tree
+};
+
+/**
+ * @brief Range of UMP words of a clip file (its header or its sequence)
+ */
+class ClipSection
+{
+public:
+  constexpr ClipSection() = default;
+  constexpr ClipSection(const std::uint8_t *data, std::size_t size) : mData{data}, mSize{size} {}
+
+  constexpr const std::uint8_t *data() const { return mData; }
+  constexpr std::size_t size() const { return mSize; }
+
+  /**
+   * @brief Sequential packet reader. Delta Clockstamps advance the time and are not reported,
+   * End of Clip ends the section
+   */
+  class Cursor
+  {
+  public:
+    constexpr Cursor() = default;
+    constexpr explicit Cursor(const ClipSection &section) : mPos{section.mData}, mEnd{section.mData + section.mSize} {}
+
+    /**
+     * @brief Reads the next packet
+     * @return SUCCESS, UNDEFINED after the end of the section or ERROR_TRUNCATED
+     */
+    constexpr SmfInfo next(ClipEvent &e)
+    {
+      while (mPos < mEnd)
+      {
+        if (mEnd - mPos < 4)
+          return fail();
+        const std::uint32_t w0 = ReadBE32(mPos);
+        const std::size_t words = UmpFraming::packetWords(w0);
+        if (std::size_t(mEnd - mPos) < 4 * words)
+          return fail();
+
+        const std::uint8_t *packet = mPos;
+        mPos += 4 * words;
+        if ((w0 & ClipFormat::StreamStatusMask) == ClipFormat::EndOfClip)
+          break;
+
+        if (UmpFraming::messageType(w0) == 0x0 && (w0 & 0x00F00000) == std::uint32_t(MidiBytes::M2::Utility::DeltaClockstamp::value) << 16)
+        {
+          mTick += w0 & 0x000FFFFF;
+          continue;
+        }
+
+        MidiEvent event{};
+        if (MidiBytes::M2::method(packet, 4 * words, &event).status() != ParseInfo::E::SUCCESS)
+          event = MidiEvent{};
+        e = ClipEvent{mTick, packet, static_cast<std::uint8_t>(words), event};
+        return {SMF_STATUS::SUCCESS};
+      }
+      mPos = mEnd;
+      return {};
+    }
+
+  private:
+    constexpr SmfInfo fail()
+    {
+      mPos = mEnd;
+      return {SMF_STATUS::ERROR_TRUNCATED};
+    }
+
+    const std::uint8_t *mPos{};
+    const std::uint8_t *mEnd{};
+    std::uint64_t mTick{};
+  };
+
+  class iterator
+  {
+  public:
+    constexpr iterator() = default;
+    constexpr explicit iterator(const ClipSection &section) : mCursor{section} { ++*this; }
+
+    constexpr const ClipEvent &operator*() const { return mEvent; }
+    constexpr const ClipEvent *operator->() const { return &mEvent; }
+    constexpr iterator &operator++()
+    {
+      mDone = mCursor.next(mEvent).status() != SMF_STATUS::SUCCESS;
+      return *this;
+    }
+    constexpr bool operator!=(const iterator &other) const { return mDone != other.mDone; }
+
+  private:
+    Cursor mCursor{};
+    ClipEvent mEvent{};
+    bool mDone{true};
+  };
+
+  constexpr iterator begin() const { return iterator{*this}; }
+  constexpr iterator end() const { return {}; }
+
+private:
+  const std::uint8_t *mData{};
+  std::size_t mSize{};
+};
+
+/**
+ * @brief MIDI Clip File, read from a memory-mapped file or from memory.
+ * Packets are decoded through MidiBytes::M2::method, which requires MidiBytes::M2::isMidi2Enabled()
+ */
+class ClipFile
+{
+public:
+  SmfInfo open(const char *path)
+  {
+    if (!mFile.open(path))
+      return {SMF_STATUS::ERROR_OPEN};
+    return parse(mFile.data(), mFile.size());
+  }
+
+  /**
+   * @brief Splits a clip file into its header & sequence. The buffer must outlive the sections
+   */
+  constexpr SmfInfo parse(const std::uint8_t *data, std::size_t size)
+  {
+    mHeader = mClip = ClipSection{};
+    mTicksPerQuarter = 0;
+    if (size < ClipFormat::signatureSize)
+      return {SMF_STATUS::ERROR_HEADER};
+    for (std::size_t i = 0; i < ClipFormat::signatureSize; ++i)
+      if (data[i] != ClipFormat::signature[i])
+        return {SMF_STATUS::ERROR_HEADER};
+
+    const std::uint8_t *begin = data + ClipFormat::signatureSize;
+    const std::uint8_t *end = data + size;
+    for (const std::uint8_t *pos = begin; end - pos >= 4;)
+    {
+      const std::uint32_t w0 = ReadBE32(pos);
+      const std::size_t words = UmpFraming::packetWords(w0);
+      if (std::size_t(end - pos) < 4 * words)
+        break;
+      if (UmpFraming::messageType(w0) == 0x0 && (w0 & 0x00F00000) == std::uint32_t(MidiBytes::M2::Utility::DeltaClockstampTPQ::value) << 16)
+        mTicksPerQuarter = static_cast<std::uint16_t>(w0);
+      pos += 4 * words;
+      if ((w0 & ClipFormat::StreamStatusMask) == ClipFormat::StartOfClip)
+      {
+        mHeader = ClipSection{begin, std::size_t(pos - begin)};
+        mClip = ClipSection{pos, std::size_t(end - pos)};
+        return {SMF_STATUS::SUCCESS};
+      }
+    }
+    return {SMF_STATUS::ERROR_HEADER};
+  }
+
+  constexpr std::uint16_t ticksPerQuarter() const { return mTicksPerQuarter; }
+  // Configuration packets, up to & including Start of Clip
+  constexpr const ClipSection &header() const { return mHeader; }
+  constexpr const ClipSection &clip() const { return mClip; }
+
+private:
+  MappedFile mFile;
+  ClipSection mHeader;
+  ClipSection mClip;
+  std::uint16_t mTicksPerQuarter{};
+};
+
+/**
+ * @brief Writes a MIDI Clip File into a sink (see smf_writer.hpp): begin(), optional header events,
+ * startClip(), timed events & endClip()
+ */
+template <typename Sink_t>
+class ClipWriter
+{
+public:
+  explicit ClipWriter(Sink_t &sink) : mSink{sink} {}
+
+  /**
+   * @brief Writes the signature & the Delta Clockstamp Ticks Per Quarter Note
+   */
+  void begin(std::uint16_t ticksPerQuarter)
+  {
+    mSink.write(reinterpret_cast<const std::uint8_t *>(ClipFormat::signature), ClipFormat::signatureSize);
+    MidiEvent tpq{EventType::DeltaClockstampTPQ, 2};
+    tpq.value = ticksPerQuarter;
+    write(tpq);
+    mTick = 0;
+  }
+
+  // Configuration message of the clip header
+  void header(const MidiEvent &e) { write(e); }
+
+  void startClip()
+  {
+    const std::uint32_t w[4] = {ClipFormat::StartOfClip};
+    words(w, 4);
+    mTick = 0;
+  }
+
+  /**
+   * @brief Writes an event of the clip sequence preceded by its Delta Clockstamp(s)
+   * @param tick absolute time in ticks, not before the previous event
+   * @param e event with a UMP representation
+   */
+  void event(std::uint64_t tick, const MidiEvent &e)
+  {
+    delta(tick);
+    // Protocol 1 events encode to one packet, except MIDI 1.0 SysEx over 6 bytes (one 2-word SysEx7 packet per 6 bytes)
+    if (e.protocol != 1 || MidiEncode::umpSize(e) <= 2)
+      return write(e);
+
+    // MIDI 1.0 SysEx: one Delta Clockstamp per SysEx7 packet
+    using D = MidiBytes::M2::Data64Bits;
+    for (std::uint32_t pos = 0; pos < e.length; pos += 6)
+    {
+      MidiEvent part{EventType::SysEx7, 2, e.group};
+      part.payload = e.payload + pos;
+      part.length = e.length - pos < 6 ? e.length - pos : 6;
+      const bool last = pos + part.length == e.length;
+      part.data2 = (pos ? (last ? D::SysExEnd::value : D::SysExContinue::value) : (last ? D::SysEx1Packet::value : D::SysExStart::value)) >> 4;
+      if (pos)
+        delta(mTick);
+      write(part);
+    }
+  }
+
+  /**
+   * @brief Writes a raw packet of the clip sequence preceded by its Delta Clockstamp(s)
+   * @param packet host order UMP words
+   */
+  void packet(std::uint64_t tick, const std::uint32_t *packet, std::size_t count)
+  {
+    delta(tick);
+    words(packet, count);
+  }
+
+  void endClip(std::uint64_t tick)
+  {
+    delta(tick);
+    const std::uint32_t w[4] = {ClipFormat::EndOfClip};
+    words(w, 4);
+  }
+
+  bool ok() const { return mSink.ok(); }
+
+private:
+  // One Delta Clockstamp per message, split when the delta exceeds 20 bits
+  void delta(std::uint64_t tick)
+  {
+    std::uint64_t d = tick > mTick ? tick - mTick : 0;
+    mTick += d;
+    do
+    {
+      MidiEvent dc{EventType::DeltaClockstamp, 2};
+      dc.value = static_cast<std::uint32_t>(d < 0xFFFFF ? d : 0xFFFFF);
+      d -= dc.value;
+      write(dc);
+    } while (d);
+  }
+
+  void write(const MidiEvent &e)
+  {
+    std::uint32_t w[4]{};
+    words(w, MidiEncode::ump(e, w));
+  }
+
+  void words(const std::uint32_t *w, std::size_t count)
+  {
+    std::uint8_t bytes[16];
+    UmpFraming::toBytes(w, count, bytes);
+    mSink.write(bytes, 4 * count);
+  }
+
+  Sink_t &mSink;
+  std::uint64_t mTick{};
+};
+
+#endif // CLIP_FILE_HPP
@@ -0,0 +1,185 @@
+#ifndef CLOCK_TRACKER_HPP
+#define CLOCK_TRACKER_HPP
+
+/**
+ * @file clock_tracker.hpp
+ * @author Etienne SANTOUL github.com/esantoul
+ * @brief MIDI beat clock tempo, transport & song position tracking for many ports
+ * @version 0.1
+ * @date 2021-02-04
+ *
+ * @copyright BSD 2-Clause License. Copyright (c) 2021, Etienne SANTOUL. All rights reserved.
+ */
+
+#include "midi_event.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+enum class Transport : std::uint8_t
+{
+  Stopped,
+  Playing,
+};
+
+/**
+ * @brief Clock state of a port, as published by ClockTracker
+ */
+struct ClockState
+{
+  float bpm{};               // 0 until two clocks were received
+  Transport transport{};
+  std::uint32_t position{};  // clocks (24 per quarter note) since the song start
+
+  // Song position in MIDI beats (sixteenth notes, 6 clocks)
+  constexpr std::uint32_t songPosition() const { return position / 6; }
+};
+
+/**
+ * @brief Follows the timing clock (24 PPQN), Start, Continue, Stop & Song Position Pointer messages of many ports.
+ * The tempo is the inverse of an exponential moving average of the clock intervals, restarted after gaps.
+ * Each port owns a cache line: one thread per port updates it, any thread reads the published state, which is a single
+ * atomic word so that reads are never torn nor blocking.
+ * @tparam ports Number of ports
+ */
+template <std::size_t ports = 256>
+class ClockTracker
+{
+public:
+  ClockTracker() = default;
+  ClockTracker(const ClockTracker &) = delete;
+  ClockTracker &operator=(const ClockTracker &) = delete;
+
+  /**
+   * @brief Applies a decoded event
+   * @param port port index
+   * @param e decoded event
+   * @param now monotonic time of the message in ns
+   * @return true if the event was a clock, transport or song position message
+   */
+  bool update(std::size_t port, const MidiEvent &e, std::int64_t now)
+  {
+    switch (e.type)
+    {
+    case EventType::TimingClock:
+      clock(port, now);
+      return true;
+    case EventType::Start:
+      start(port);
+      return true;
+    case EventType::Continue:
+      resume(port);
+      return true;
+    case EventType::Stop:
+      stop(port);
+      return true;
+    case EventType::SongPos:
+      songPosition(port, e.value);
+      return true;
+    default:
+      return false;
+    }
+  }
+
+  void clock(std::size_t port, std::int64_t now)
+  {
+    Slot &s = mSlots[port];
+    const std::int64_t dt = now - s.last;
+    s.last = now;
+    if (s.primed)
+    {
+      // An interval much longer than the average is a gap (clock paused or lost): keep the tempo & restart the
+      // average from the next interval
+      if (s.interval && !s.restart && dt > 8 * (s.interval >> shift))
+        s.restart = true;
+      else if (!s.interval || s.restart)
+      {
+        s.interval = dt << shift;
+        s.restart = false;
+      }
+      else
+        s.interval += ((dt << shift) - s.interval) >> smoothing;
+    }
+    s.primed = true;
+    s.position += s.transport == Transport::Playing;
+    publish(s);
+  }
+
+  // Start: playback from the song start, the next clock is the first one
+  void start(std::size_t port)
+  {
+    Slot &s = mSlots[port];
+    s.transport = Transport::Playing;
+    s.position = 0;
+    publish(s);
+  }
+
+  void resume(std::size_t port)
+  {
+    Slot &s = mSlots[port];
+    s.transport = Transport::Playing;
+    publish(s);
+  }
+
+  void stop(std::size_t port)
+  {
+    Slot &s = mSlots[port];
+    s.transport = Transport::Stopped;
+    publish(s);
+  }
+
+  // @param beats MIDI beats (sixteenth notes) since the song start
+  void songPosition(std::size_t port, std::uint32_t beats)
+  {
+    Slot &s = mSlots[port];
+    s.position = 6 * beats;
+    publish(s);
+  }
+
+  void reset(std::size_t port)
+  {
+    Slot &s = mSlots[port];
+    s.last = s.interval = 0;
+    s.position = 0;
+    s.primed = s.restart = false;
+    s.transport = Transport::Stopped;
+    publish(s);
+  }
+
+  /**
+   * @brief Reads the last published state of a port, from any thread
+   */
+  ClockState read(std::size_t port) const
+  {
+    const std::uint64_t w = mSlots[port].published.load(std::memory_order_acquire);
+    return {static_cast<float>(w >> 40) / 100.f, static_cast<Transport>(w >> 32 & 0x01), static_cast<std::uint32_t>(w)};
+  }
+
+private:
+  static constexpr unsigned shift = 4;     // fixed point bits of the average interval
+  static constexpr unsigned smoothing = 3; // moving average weight 1/8
+
+  struct alignas(64) Slot
+  {
+    std::int64_t last{};
+    std::int64_t interval{}; // average clock interval in ns << shift
+    std::uint32_t position{};
+    Transport transport{};
+    bool primed{};  // a clock was received
+    bool restart{}; // the last interval was a gap
+    // BPM * 100 (24 bits) | transport (bit 32) | position (32 bits)
+    std::atomic<std::uint64_t> published{0};
+  };
+
+  static void publish(Slot &s)
+  {
+    // 60 s / (24 clocks * interval), in hundredths of BPM
+    const std::uint64_t cbpm = s.interval > 0 ? (std::uint64_t{6000} * 1000000000 << shift) / (24 * std::uint64_t(s.interval)) : 0;
+    const std::uint64_t w = (cbpm < 0xFFFFFF ? cbpm : 0xFFFFFF) << 40 | std::uint64_t(s.transport) << 32 | s.position;
+    s.published.store(w, std::memory_order_release);
+  }
+
+  Slot mSlots[ports]{};
+};
+
+#endif // CLOCK_TRACKER_HPP
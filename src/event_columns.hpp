@@ -0,0 +1,234 @@
+#ifndef EVENT_COLUMNS_HPP
+#define EVENT_COLUMNS_HPP
+
+/**
+ * @file event_columns.hpp
+ * @author Etienne SANTOUL github.com/esantoul
+ * @brief Struct-of-arrays storage of decoded MIDI events
+ * @version 0.1
+ * @date 2021-02-04
+ *
+ * @copyright BSD 2-Clause License. Copyright (c) 2021, Etienne SANTOUL. All rights reserved.
+ */
+
+#include "midi_parser.hpp"
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Decoded events stored column by column with a shared length.
+ * Every column is a contiguous, 64-byte aligned array so that per-column scans vectorize.
+ * Large capacities should be allocated on the heap (e.g. std::make_unique<EventColumns<1 << 20>>()).
+ * @tparam capacity Maximum number of events
+ */
+template <std::size_t capacity>
+class EventColumns
+{
+public:
+  constexpr EventColumns() = default;
+
+  constexpr std::size_t size() const { return mSize; }
+  static constexpr std::size_t max_size() { return capacity; }
+  constexpr void clear() { mSize = 0; }
+
+  /**
+   * @brief Appends a decoded event
+   * @return false if the container is full
+   */
+  constexpr bool append(std::uint64_t timestamp, const MidiEvent &e)
+  {
+    if (mSize == capacity)
+      return false;
+    mTimestamp[mSize] = timestamp;
+    mType[mSize] = e.type;
+    mProtocol[mSize] = e.protocol;
+    mGroup[mSize] = e.group;
+    mChannel[mSize] = e.channel;
+    mData1[mSize] = e.data1;
+    mData2[mSize] = e.data2;
+    mData16[mSize] = e.data16;
+    mValue[mSize] = e.value;
+    mLength[mSize] = e.length;
+    mPayload[mSize] = e.payload;
+    ++mSize;
+    return true;
+  }
+
+  /**
+   * @brief Decodes a message with MidiBytes::Interpret and appends it
+   * @return the MidiBytes::Interpret status, ERROR_UNKNOWN if the container is full
+   */
+  constexpr ParseInfo append(std::uint64_t timestamp, const std::uint8_t *bytes, std::size_t length)
+  {
+    MidiEvent e{};
+    const ParseInfo ret = MidiBytes::Interpret(bytes, length, &e);
+    if (ret.status() != ParseInfo::E::SUCCESS)
+      return ret;
+    return append(timestamp, e) ? ret : ParseInfo{ParseInfo::E::ERROR_UNKNOWN};
+  }
+
+  // Row i as a MidiEvent
+  constexpr MidiEvent operator[](std::size_t i) const
+  {
+    MidiEvent e{mType[i], mProtocol[i], mGroup[i], mChannel[i], mData1[i], mData2[i], mData16[i], mValue[i]};
+    e.length = mLength[i], e.payload = mPayload[i];
+    return e;
+  }
+
+  // Columns. Payloads point into the buffers the events were decoded from, see MidiEvent
+  constexpr const std::uint64_t *timestamp() const { return mTimestamp; }
+  constexpr const EventType *type() const { return mType; }
+  constexpr const std::uint8_t *protocol() const { return mProtocol; }
+  constexpr const std::uint8_t *group() const { return mGroup; }
+  constexpr const std::uint8_t *channel() const { return mChannel; }
+  constexpr const std::uint8_t *data1() const { return mData1; }
+  constexpr const std::uint8_t *data2() const { return mData2; }
+  constexpr const std::uint16_t *data16() const { return mData16; }
+  constexpr const std::uint32_t *value() const { return mValue; }
+  constexpr const std::uint32_t *length() const { return mLength; }
+  constexpr const std::uint8_t *const *payload() const { return mPayload; }
+
+  constexpr std::uint64_t *timestamp() { return mTimestamp; }
+  constexpr std::uint8_t *data1() { return mData1; }
+  constexpr std::uint8_t *data2() { return mData2; }
+  constexpr std::uint16_t *data16() { return mData16; }
+  constexpr std::uint32_t *value() { return mValue; }
+
+  /**
+   * @brief Row indices of the events of a given type
+   */
+  class View
+  {
+  public:
+    constexpr View(const EventColumns &cols, EventType t) : mCols{cols}, mT{t} {}
+
+    class iterator
+    {
+    public:
+      constexpr iterator(const EventColumns &cols, EventType t, std::size_t idx) : mCols{cols}, mT{t}, mIdx{idx} { skip(); }
+      constexpr std::size_t operator*() const { return mIdx; }
+      constexpr iterator &operator++()
+      {
+        ++mIdx;
+        skip();
+        return *this;
+      }
+      constexpr bool operator!=(const iterator &other) const { return mIdx != other.mIdx; }
+
+    private:
+      constexpr void skip()
+      {
+        while (mIdx < mCols.size() && mCols.mType[mIdx] != mT)
+          ++mIdx;
+      }
+
+      const EventColumns &mCols;
+      EventType mT;
+      std::size_t mIdx;
+    };
+
+    constexpr iterator begin() const { return {mCols, mT, 0}; }
+    constexpr iterator end() const { return {mCols, mT, mCols.size()}; }
+
+  private:
+    const EventColumns &mCols;
+    EventType mT;
+  };
+
+  constexpr View filter(EventType t) const { return {*this, t}; }
+
+  /**
+   * @brief Writes the row indices of the events of a given type
+   * @return the number of indices written
+   */
+  constexpr std::size_t select(EventType t, std::uint32_t *indices, std::size_t max) const
+  {
+    std::size_t n = 0;
+    for (std::size_t i = 0; i < mSize && n < max; ++i)
+    {
+      indices[n] = static_cast<std::uint32_t>(i);
+      n += mType[i] == t;
+    }
+    return n;
+  }
+
+  /**
+   * @brief Maximum `value` per group & channel among the events of a given type & protocol (e.g. the maximum MIDI 1.0
+   * NoteOn velocity per channel). Protocols are kept apart as their value resolutions differ (7 or 14 bits against 16 or
+   * 32 bits). Finds the groups holding matching events, then their channels, then runs one max reduction per group &
+   * channel present: every pass is a branchless reduction over the columns, which vectorizes.
+   * @param out maximum indexed by [group][channel], 0 where no event matches. MIDI 1.0 byte streams are group 0
+   */
+  constexpr void maxValuePerChannel(EventType t, std::uint8_t protocol, std::uint32_t (&out)[16][16]) const
+  {
+    for (auto &group : out)
+      for (auto &channel : group)
+        channel = 0;
+    for (std::uint32_t groups = groupMask(t, protocol); groups; groups &= groups - 1)
+    {
+      const std::uint8_t g = static_cast<std::uint8_t>(__builtin_ctz(groups));
+      for (std::uint32_t channels = channelMask(t, protocol, g); channels; channels &= channels - 1)
+      {
+        const std::uint8_t c = static_cast<std::uint8_t>(__builtin_ctz(channels));
+        out[g][c] = maxValue(t, protocol, g, c);
+      }
+    }
+  }
+
+private:
+  // Folds the row terms f(i) with op, 64 rows at a time: GCC vectorizes the constant trip count inner loop at -O2 as well
+  // (its cheap cost model gives up on loops that need an epilogue)
+  template <class Op, class F>
+  constexpr std::uint32_t fold(Op op, F f) const
+  {
+    std::uint32_t m = 0;
+    std::size_t i = 0;
+    for (; i + 64 <= mSize; i += 64)
+      for (std::size_t j = 0; j < 64; ++j)
+        m = op(m, f(i + j));
+    for (; i < mSize; ++i)
+      m = op(m, f(i));
+    return m;
+  }
+
+  // Rows of type t & protocol as an all ones mask, masks rather than selects, which load conditionally & keep the loops scalar
+  constexpr std::uint32_t match(std::size_t i, EventType t, std::uint8_t protocol) const
+  {
+    return 0u - ((mType[i] == t) & (mProtocol[i] == protocol));
+  }
+
+  // Bit g set for each group g holding an event of type t & protocol
+  constexpr std::uint32_t groupMask(EventType t, std::uint8_t protocol) const
+  {
+    return fold([](std::uint32_t m, std::uint32_t v) { return m | v; },
+                [&](std::size_t i) { return (1u << (mGroup[i] & 0x0F)) & match(i, t, protocol); });
+  }
+
+  // Bit c set for each channel c of group g holding an event of type t & protocol
+  constexpr std::uint32_t channelMask(EventType t, std::uint8_t protocol, std::uint8_t g) const
+  {
+    return fold([](std::uint32_t m, std::uint32_t v) { return m | v; },
+                [&](std::size_t i) { return (1u << (mChannel[i] & 0x0F)) & match(i, t, protocol) & (0u - ((mGroup[i] & 0x0F) == g)); });
+  }
+
+  constexpr std::uint32_t maxValue(EventType t, std::uint8_t protocol, std::uint8_t g, std::uint8_t c) const
+  {
+    return fold([](std::uint32_t m, std::uint32_t v) { return v > m ? v : m; },
+                [&](std::size_t i) { return mValue[i] & match(i, t, protocol) & (0u - (((mGroup[i] & 0x0F) == g) & ((mChannel[i] & 0x0F) == c))); });
+  }
+
+  std::size_t mSize{};
+  alignas(64) std::uint64_t mTimestamp[capacity]{};
+  alignas(64) EventType mType[capacity]{};
+  alignas(64) std::uint8_t mProtocol[capacity]{};
+  alignas(64) std::uint8_t mGroup[capacity]{};
+  alignas(64) std::uint8_t mChannel[capacity]{};
+  alignas(64) std::uint8_t mData1[capacity]{};
+  alignas(64) std::uint8_t mData2[capacity]{};
+  alignas(64) std::uint16_t mData16[capacity]{};
+  alignas(64) std::uint32_t mValue[capacity]{};
+  alignas(64) std::uint32_t mLength[capacity]{};
+  alignas(64) const std::uint8_t *mPayload[capacity]{};
+};
+
+#endif // EVENT_COLUMNS_HPP
@@ -0,0 +1,178 @@
+#ifndef JR_TRACKER_HPP
+#define JR_TRACKER_HPP
+
+/**
+ * @file jr_tracker.hpp
+ * @author Etienne SANTOUL github.com/esantoul
+ * @brief UMP Jitter Reduction clock & timestamp tracking
+ * @version 0.1
+ * @date 2021-02-04
+ *
+ * @copyright BSD 2-Clause License. Copyright (c) 2021, Etienne SANTOUL. All rights reserved.
+ */
+
+#include "midi_event.hpp"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Time of an event: the sender time given by the last JR Timestamp of its group & that time mapped onto the local clock
+ */
+struct JrStamp
+{
+  bool valid{};           // a JR Timestamp preceded the event in its group
+  std::uint64_t sender{}; // unwrapped sender time in ns
+  std::int64_t local{};   // sender time on the local monotonic clock in ns, sender time + offset while not synchronized
+};
+
+struct TimedEvent
+{
+  MidiEvent event{};
+  JrStamp time{};
+};
+
+/**
+ * @brief Tracks the sender clock of each UMP group from JR Clock messages & stamps the packets that follow a JR Timestamp.
+ * The 16-bit JR times (1/31250 s units) are unwrapped into 64-bit sender times. Each JR Clock is compared with the local
+ * time it was received at: the offset & drift between both clocks are estimated by an asymmetric filter that follows
+ * earlier arrivals quickly & later arrivals slowly, since transport jitter only ever delays messages.
+ * @tparam groups Number of UMP groups
+ */
+template <std::size_t groups = 16>
+class JrTracker
+{
+public:
+  static constexpr std::uint64_t nsPerTick = 32000;
+
+  static std::int64_t monotonicNs()
+  {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+
+  /**
+   * @brief Updates the group state with a decoded event & returns the time of the event
+   * @param e decoded UMP event
+   * @param now local monotonic time at which the packet was received, in ns
+   * @return the stamp of the event, invalid for JR Clock & JR Timestamp messages and for events without a preceding timestamp
+   */
+  constexpr JrStamp track(const MidiEvent &e, std::int64_t now)
+  {
+    Group &g = mGroups[e.group % groups];
+    switch (e.type)
+    {
+    case EventType::JRClock:
+      clock(g, unwrap(g, static_cast<std::uint16_t>(e.value)), now);
+      return {};
+    case EventType::JRTimestamp:
+      g.stamp = unwrap(g, static_cast<std::uint16_t>(e.value));
+      g.stamped = true;
+      return {};
+    default:
+      if (!g.stamped)
+        return {};
+      return {true, g.stamp * nsPerTick, toLocal(g, g.stamp * nsPerTick)};
+    }
+  }
+
+  /**
+   * @brief Stamps a batch of decoded events received at the same local time. JR Clock & JR Timestamp messages are consumed
+   * @return the number of events written to `out`
+   */
+  constexpr std::size_t track(const MidiEvent *events, std::size_t count, TimedEvent *out, std::int64_t now)
+  {
+    std::size_t n = 0;
+    for (std::size_t i = 0; i < count; ++i)
+    {
+      const JrStamp t = track(events[i], now);
+      if (events[i].type != EventType::JRClock && events[i].type != EventType::JRTimestamp)
+        out[n++] = TimedEvent{events[i], t};
+    }
+    return n;
+  }
+
+  /**
+   * @brief Maps a sender time of a group onto the local clock
+   */
+  constexpr std::int64_t toLocal(std::uint8_t group, std::uint64_t sender) const { return toLocal(mGroups[group % groups], sender); }
+
+  // A JR Clock was received for the group
+  constexpr bool synchronized(std::uint8_t group) const { return mGroups[group % groups].synced; }
+  // Local minus sender time in ns, at the last JR Clock
+  constexpr std::int64_t offset(std::uint8_t group) const { return mGroups[group % groups].offset; }
+  // Local clock rate relative to the sender clock, in parts per million
+  constexpr double drift(std::uint8_t group) const { return mGroups[group % groups].drift * 1e6; }
+
+  constexpr void reset(std::uint8_t group) { mGroups[group % groups] = Group{}; }
+
+  constexpr void reset()
+  {
+    for (Group &g : mGroups)
+      g = Group{};
+  }
+
+private:
+  // Drift estimates beyond this bound are clock errors rather than oscillator drift
+  static constexpr double maxDrift = 500e-6;
+
+  struct Group
+  {
+    std::uint64_t ticks{};  // last unwrapped sender time in JR ticks
+    std::uint64_t stamp{};  // last JR Timestamp in JR ticks
+    std::int64_t offset{};  // local - sender in ns, at `last`
+    std::int64_t last{};    // local time of the last JR Clock
+    double drift{};         // local ns per sender ns - 1
+    bool seen{};
+    bool synced{};
+    bool stamped{};
+  };
+
+  // JR times are 16-bit & wrap every 2.1 s: extend them by the signed distance to the last time seen
+  static constexpr std::uint64_t unwrap(Group &g, std::uint16_t time)
+  {
+    if (!g.seen)
+    {
+      g.seen = true;
+      return g.ticks = time;
+    }
+    const std::int16_t d = static_cast<std::int16_t>(static_cast<std::uint16_t>(time - static_cast<std::uint16_t>(g.ticks)));
+    if (d > 0 || g.ticks >= std::uint64_t(-d))
+      g.ticks += d;
+    return g.ticks;
+  }
+
+  static constexpr void clock(Group &g, std::uint64_t ticks, std::int64_t now)
+  {
+    const std::int64_t measured = now - static_cast<std::int64_t>(ticks * nsPerTick);
+    if (!g.synced)
+    {
+      g.synced = true;
+      g.offset = measured;
+      g.last = now;
+      return;
+    }
+    const std::int64_t dt = now - g.last;
+    const std::int64_t predicted = g.offset + static_cast<std::int64_t>(g.drift * static_cast<double>(dt));
+    const std::int64_t err = measured - predicted;
+    // Earlier than predicted: less transport delay than assumed, follow quickly. Later: mostly jitter, follow slowly
+    const std::int64_t correction = err < 0 ? err / 2 : err / 16;
+    g.offset = predicted + correction;
+    // The corrections average out once the drift matches: integrate them rather than the skewed raw error
+    if (dt > 0)
+    {
+      g.drift += static_cast<double>(correction) / static_cast<double>(dt) / 16;
+      g.drift = g.drift > maxDrift ? maxDrift : (g.drift < -maxDrift ? -maxDrift : g.drift);
+    }
+    g.last = now;
+  }
+
+  static constexpr std::int64_t toLocal(const Group &g, std::uint64_t sender)
+  {
+    const std::int64_t base = static_cast<std::int64_t>(sender) + g.offset;
+    return base + static_cast<std::int64_t>(g.drift * static_cast<double>(base - g.last));
+  }
+
+  Group mGroups[groups]{};
+};
+
+#endif // JR_TRACKER_HPP
@@ -0,0 +1,97 @@
+#ifndef MAPPED_FILE_HPP
+#define MAPPED_FILE_HPP
+
+/**
+ * @file mapped_file.hpp
+ * @author Etienne SANTOUL github.com/esantoul
+ * @brief Read-only memory-mapped file (POSIX)
+ * @version 0.1
+ * @date 2021-02-04
+ *
+ * @copyright BSD 2-Clause License. Copyright (c) 2021, Etienne SANTOUL. All rights reserved.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * @brief Owns a private read-only mapping of a whole file. Move only.
+ */
+class MappedFile
+{
+public:
+  MappedFile() = default;
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  MappedFile(MappedFile &&other) noexcept : mData{other.mData}, mSize{other.mSize}
+  {
+    other.mData = nullptr;
+    other.mSize = 0;
+  }
+
+  MappedFile &operator=(MappedFile &&other) noexcept
+  {
+    if (this != &other)
+    {
+      close();
+      mData = other.mData;
+      mSize = other.mSize;
+      other.mData = nullptr;
+      other.mSize = 0;
+    }
+    return *this;
+  }
+
+  ~MappedFile() { close(); }
+
+  /**
+   * @brief Maps a file, replacing the current mapping
+   * @param path file path
+   * @return false if the file cannot be opened, is empty or cannot be mapped
+   */
+  bool open(const char *path)
+  {
+    close();
+    const int fd = ::open(path, O_RDONLY);
+    if (fd < 0)
+      return false;
+
+    struct stat st
+    {
+    };
+    void *map = MAP_FAILED;
+    if (::fstat(fd, &st) == 0 && st.st_size > 0)
+      map = ::mmap(nullptr, static_cast<std::size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd); // the mapping keeps its own reference to the file
+
+    if (map == MAP_FAILED)
+      return false;
+    ::madvise(map, static_cast<std::size_t>(st.st_size), MADV_SEQUENTIAL);
+    mData = static_cast<const std::uint8_t *>(map);
+    mSize = static_cast<std::size_t>(st.st_size);
+    return true;
+  }
+
+  void close()
+  {
+    if (mData)
+      ::munmap(const_cast<std::uint8_t *>(mData), mSize);
+    mData = nullptr;
+    mSize = 0;
+  }
+
+  bool isOpen() const { return mData != nullptr; }
+  const std::uint8_t *data() const { return mData; }
+  std::size_t size() const { return mSize; }
+
+private:
+  const std::uint8_t *mData{};
+  std::size_t mSize{};
+};
+
+#endif // MAPPED_FILE_HPP
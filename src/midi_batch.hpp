@@ -0,0 +1,224 @@
+#ifndef MIDI_BATCH_HPP
+#define MIDI_BATCH_HPP
+
+/**
+ * @file midi_batch.hpp
+ * @author Etienne SANTOUL github.com/esantoul
+ * @brief Batch interpretation of concatenated MIDI messages & UMP words
+ * @version 0.1
+ * @date 2021-02-04
+ *
+ * @copyright BSD 2-Clause License. Copyright (c) 2021, Etienne SANTOUL. All rights reserved.
+ */
+
+#include "midi_decode.hpp"
+#include "midi_parser.hpp"
+#include "ump_stream.hpp"
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief MIDI 1.0 byte stream framing: running status, realtime bytes interleaved anywhere & SysEx delimited by F7
+ */
+struct M1Framing : NotInstantiable
+{
+  struct Unit
+  {
+    enum class Kind : std::uint8_t
+    {
+      Incomplete, // the buffer ends inside a message
+      Bytes,      // no message: realtime, stray data, undefined status or interrupted message bytes
+      Message,    // channel or system common message
+      SysEx,      // F0 to F7
+    };
+
+    Kind kind{};
+    std::size_t end{};         // offset after the unit. Realtime bytes in the unit are interleaved or lone realtime messages
+    std::uint8_t message[3]{}; // Message with its status byte (the running status when omitted), realtime bytes left out
+    std::uint8_t length{};
+  };
+
+  /**
+   * @brief Frames the unit starting at `pos`
+   * @param running running status, updated by the unit (0 when none)
+   */
+  static constexpr Unit next(const std::uint8_t *bytes, std::size_t length, std::size_t pos, std::uint8_t &running)
+  {
+    Unit u{};
+    const std::uint8_t b = bytes[pos];
+    if (b >= 0xF8)
+      return {Unit::Kind::Bytes, pos + 1};
+
+    std::size_t p = pos;
+    if (b == 0xF0)
+    {
+      running = 0;
+      while (++p < length && (bytes[p] < 0x80 || bytes[p] >= 0xF8))
+        ;
+      if (p == length)
+        return {};
+      // A SysEx interrupted by a status byte is dropped, the status byte starts the next unit
+      return bytes[p] == 0xF7 ? Unit{Unit::Kind::SysEx, p + 1} : Unit{Unit::Kind::Bytes, p};
+    }
+    if (b >= 0x80)
+    {
+      const MidiSize sz = MidiBytes::M1::insight(b);
+      running = b < 0xF0 && sz.status() == MidiSize::Status::Set ? b : 0;
+      if (sz.status() != MidiSize::Status::Set)
+        return {Unit::Kind::Bytes, pos + 1};
+      u.message[0] = b;
+      ++p;
+    }
+    else if (running)
+      u.message[0] = running;
+    else
+      return {Unit::Kind::Bytes, pos + 1};
+
+    const std::size_t size = MidiBytes::M1::insight(u.message[0]).value();
+    for (u.length = 1; u.length < size; ++p)
+    {
+      if (p == length)
+        return {};
+      if (bytes[p] >= 0xF8)
+        continue;
+      if (bytes[p] >= 0x80)
+        return {Unit::Kind::Bytes, p};
+      u.message[u.length++] = bytes[p];
+    }
+    u.kind = Unit::Kind::Message;
+    u.end = p;
+    return u;
+  }
+
+  // Realtime bytes of bytes [from, to)
+  static constexpr std::size_t realtime(const std::uint8_t *bytes, std::size_t from, std::size_t to)
+  {
+    std::size_t n = 0;
+    for (; from < to; ++from)
+      n += bytes[from] >= 0xF8;
+    return n;
+  }
+};
+
+/**
+ * @brief Interprets as many complete MIDI 1.0 messages as available, framed by M1Framing (UMP go through InterpretWords).
+ * Channel voice messages are decoded in place by DecodeM1Channel, as the DecodeM1 leaf methods do, the others go through Interpret
+ * @param bytes MIDI 1.0 byte stream, running status & interleaved realtime bytes included
+ * @param length number of input bytes
+ * @param events output events
+ * @param capacity number of output events available
+ * @param running running status, carried from one call to the next
+ * @return consumed bytes & produced events. Realtime bytes interleaved in a message are produced before it. Messages that
+ * do not decode successfully are consumed without producing an event. A SysEx event payload still holds the realtime bytes
+ * interleaved in it. A trailing incomplete message (including an unterminated SysEx) is left for the next call
+ */
+constexpr BatchInfo MidiBytes::InterpretBatch(const std::uint8_t *bytes, std::size_t length, MidiEvent *events, std::size_t capacity, std::uint8_t &running)
+{
+  std::size_t pos = 0;
+  std::size_t n = 0;
+  while (pos < length)
+  {
+    // Fast path: complete channel voice messages without interleaved realtime byte, decoded where they are (status byte
+    // included or omitted) with a single status lookup
+    std::uint8_t rs = running; // kept out of memory, the event stores could alias it
+    while (pos < length && n < capacity)
+    {
+      const std::uint8_t b = bytes[pos];
+      const std::uint8_t st = b & 0x80 ? b : rs;
+      if (st < 0x80 || st >= 0xF0)
+        break;
+      const std::size_t data = pos + (b >> 7);
+      if (data + 2 > length)
+        break; // the last bytes go through M1Framing, the fast path always reads 2 data bytes
+      const std::uint8_t d1 = bytes[data];
+      const std::uint8_t d2 = bytes[data + 1];
+      const bool twoBytes = (st & 0xE0) == 0xC0;
+      if ((d1 | (twoBytes ? 0 : d2)) & 0x80)
+        break;
+      events[n++] = DecodeM1Channel(st, d1, d2);
+      rs = st;
+      pos = data + 2 - twoBytes;
+    }
+    running = rs;
+    if (pos == length)
+      break;
+    if (bytes[pos] >= 0xF8 && n < capacity)
+    {
+      n += Interpret(bytes + pos, 1, events + n).status() == ParseInfo::E::SUCCESS;
+      ++pos;
+      continue;
+    }
+
+    const std::uint8_t prev = running;
+    const M1Framing::Unit u = M1Framing::next(bytes, length, pos, running);
+    const bool message = u.kind == M1Framing::Unit::Kind::Message || u.kind == M1Framing::Unit::Kind::SysEx;
+    if (u.kind == M1Framing::Unit::Kind::Incomplete || n + M1Framing::realtime(bytes, pos, u.end) + message > capacity)
+    {
+      running = prev;
+      break;
+    }
+
+    for (std::size_t i = pos; i < u.end; ++i)
+      if (bytes[i] >= 0xF8)
+        n += Interpret(bytes + i, 1, events + n).status() == ParseInfo::E::SUCCESS;
+    if (u.kind == M1Framing::Unit::Kind::Message)
+      n += Interpret(u.message, u.length, events + n).status() == ParseInfo::E::SUCCESS;
+    else if (u.kind == M1Framing::Unit::Kind::SysEx)
+      n += Interpret(bytes + pos, u.end - pos, events + n).status() == ParseInfo::E::SUCCESS;
+    pos = u.end;
+  }
+  return {pos, n};
+}
+
+// InterpretBatch starting without running status
+constexpr BatchInfo MidiBytes::InterpretBatch(const std::uint8_t *bytes, std::size_t length, MidiEvent *events, std::size_t capacity)
+{
+  std::uint8_t running = 0;
+  return InterpretBatch(bytes, length, events, capacity, running);
+}
+
+/**
+ * @brief Interprets as many complete Universal MIDI Packets as available.
+ * Channel voice packets are decoded from the words by DecodeUmpChannel, as the DecodeM1Packet & DecodeM2 leaf methods do,
+ * the others go through the MidiBytes::M2 method table
+ * @param words packed 32-bit UMP words
+ * @param count number of input words
+ * @param events output events
+ * @param capacity number of output events available
+ * @return consumed words & produced events. Packets that do not decode successfully are consumed without producing an event.
+ * The event payload of data packets is cleared since the words are not in wire byte order, use UmpStream to collect SysEx data
+ */
+constexpr BatchInfo MidiBytes::InterpretWords(const std::uint32_t *words, std::size_t count, MidiEvent *events, std::size_t capacity)
+{
+  std::size_t pos = 0;
+  std::size_t n = 0;
+  while (pos < count && n < capacity)
+  {
+    const std::size_t sz = UmpFraming::packetWords(words[pos]);
+    if (pos + sz > count)
+      break;
+
+    // Fast path: MIDI 1.0 & MIDI 2.0 channel voice packets decoded from the words
+    const std::uint32_t mt = words[pos] >> 28;
+    const std::uint32_t status = (words[pos] >> 20) & 0x0F;
+    if ((mt == 0x2 || mt == 0x4) && status >= 0x8 && status < 0xF && M2::isMidi2Enabled())
+    {
+      events[n++] = DecodeUmpChannel(words[pos], mt == 0x4 ? words[pos + 1] : 0);
+      pos += sz;
+      continue;
+    }
+
+    std::uint8_t packet[16]{};
+    UmpFraming::toBytes(words + pos, sz, packet);
+    // Single indirect call through the flattened message type table, as M2::method decodes
+    if (M2::methodTable[packet[0]](packet, 4 * sz, events + n).status() == ParseInfo::E::SUCCESS)
+    {
+      events[n].payload = nullptr;
+      ++n;
+    }
+    pos += sz;
+  }
+  return {pos, n};
+}
+
+#endif // MIDI_BATCH_HPP
@@ -0,0 +1,172 @@
+#ifndef MIDI_DECODE_HPP
+#define MIDI_DECODE_HPP
+
+/**
+ * @file midi_decode.hpp
+ * @author Etienne SANTOUL github.com/esantoul
+ * @brief MidiEvent decoding tasks, usable as MidiBytes leaf methods
+ * @version 0.1
+ * @date 2021-02-04
+ *
+ * @copyright BSD 2-Clause License. Copyright (c) 2021, Etienne SANTOUL. All rights reserved.
+ */
+
+#include "midi_parser.hpp"
+#include <cstddef>
+#include <cstdint>
+
+constexpr std::uint16_t ReadBE16(const std::uint8_t *bytes) { return std::uint16_t(bytes[0] << 8 | bytes[1]); }
+constexpr std::uint32_t ReadBE32(const std::uint8_t *bytes) { return std::uint32_t(ReadBE16(bytes)) << 16 | ReadBE16(bytes + 2); }
+
+// Decode Tasks
+
+// DecodeM1 of a channel voice message given by its status & data bytes (d2 unused by 2 byte messages), the type picked at
+// run time without branches. Decodes messages sent with running status where they are (MidiBytes::InterpretBatch)
+constexpr MidiEvent DecodeM1Channel(std::uint8_t status, std::uint8_t d1, std::uint8_t d2)
+{
+  const std::uint8_t type = status & 0xF0;
+  d1 &= 0x7F;
+  d2 = (type & 0xE0) == 0xC0 ? 0 : d2 & 0x7F;
+  MidiEvent e{static_cast<EventType>(type), 1, 0, std::uint8_t(status & 0x0F)};
+  // Channel pressure & pitch bend carry a value only (d2 is 0 for channel pressure), program change a number only
+  const std::uint32_t valueOnly = 0u - (type >= 0xD0); // mask rather than select, compilers branch on the select
+  e.data1 = static_cast<std::uint8_t>(d1 & ~valueOnly);
+  e.value = (std::uint32_t(d1 | d2 << 7) & valueOnly) | (d2 & ~valueOnly);
+  return e;
+}
+
+// DecodeM1Packet & DecodeM2 of a channel voice packet given by its words (message type 0x2 or 0x4, status 0x8 to 0xE),
+// decoded without unpacking the bytes (MidiBytes::InterpretWords)
+constexpr MidiEvent DecodeUmpChannel(std::uint32_t w0, std::uint32_t w1)
+{
+  const std::uint8_t status = static_cast<std::uint8_t>(w0 >> 16);
+  const std::uint8_t group = (w0 >> 24) & 0x0F;
+  if (w0 >> 28 == 0x2)
+  {
+    MidiEvent e = DecodeM1Channel(status, static_cast<std::uint8_t>(w0 >> 8), static_cast<std::uint8_t>(w0));
+    e.group = group;
+    return e;
+  }
+  const EventType type = static_cast<EventType>(status & 0xF0);
+  MidiEvent e{type, 2, group, std::uint8_t(status & 0x0F), std::uint8_t(w0 >> 8), std::uint8_t(w0)};
+  if (type == EventType::NoteOff || type == EventType::NoteOn)
+    e.value = w1 >> 16, e.data16 = static_cast<std::uint16_t>(w1);
+  else if (type == EventType::ProgramChange)
+    e.data1 = (w1 >> 24) & 0x7F, e.data16 = static_cast<std::uint16_t>((w1 >> 8 & 0x7F) << 7 | (w1 & 0x7F));
+  else
+    e.value = w1;
+  return e;
+}
+
+// MIDI 1.0 channel voice & system common/realtime messages. The message size is the MidiBytes insight of the type status byte
+template <EventType type>
+constexpr auto DecodeM1 = [](const std::uint8_t *bytes, std::size_t length, MidiEvent *out) -> ParseInfo {
+  constexpr std::size_t len = MidiBytes::M1::insight(static_cast<std::uint8_t>(type)).value();
+  if (length < len)
+    return {ParseInfo::E::ERROR_MSG_TOO_SHORT};
+
+  MidiEvent e{type, 1};
+  if constexpr (type < EventType::SysEx)
+    e.channel = bytes[0] & 0x0F;
+  if constexpr (type == EventType::PitchBend || type == EventType::SongPos)
+    e.value = (bytes[1] & 0x7F) | (bytes[2] & 0x7F) << 7;
+  else if constexpr (type == EventType::ChannelPressure)
+    e.value = bytes[1] & 0x7F;
+  else if constexpr (len == 2)
+    e.data1 = bytes[1] & 0x7F;
+  else if constexpr (len == 3)
+    e.data1 = bytes[1] & 0x7F, e.value = bytes[2] & 0x7F;
+  *out = e;
+  return {ParseInfo::E::SUCCESS};
+};
+
+// MIDI 1.0 SysEx, bytes start after F0
+constexpr auto DecodeSysEx = [](const std::uint8_t *bytes, std::size_t length, MidiEvent *out) -> ParseInfo {
+  if (length < 1)
+    return {ParseInfo::E::ERROR_MSG_TOO_SHORT};
+  *out = MidiEvent{EventType::SysEx, 1, 0, 0, bytes[0]};
+  out->payload = bytes, out->length = static_cast<std::uint32_t>(length);
+  return {ParseInfo::E::SUCCESS};
+};
+
+// MIDI 1.0 Universal SysEx, bytes start at the device ID (after the 0x7E/0x7F ID byte)
+template <EventType type>
+constexpr auto DecodeUniversal = [](const std::uint8_t *bytes, std::size_t length, MidiEvent *out) -> ParseInfo {
+  if (length < 2)
+    return {ParseInfo::E::ERROR_MSG_TOO_SHORT};
+  *out = MidiEvent{type, 1, 0, 0, bytes[0], bytes[1], std::uint16_t(length > 2 ? bytes[2] : 0)};
+  out->payload = bytes - 1, out->length = static_cast<std::uint32_t>(length + 1);
+  return {ParseInfo::E::SUCCESS};
+};
+
+// MIDI 1.0 Sample Dump Standard header (sub-ID#1 0x01), data packet (0x02) & dump request (0x03), bytes start at the device ID.
+// data16 is the sample number, or the running packet number for data packets. value is the sample format (bits) for headers
+template <std::uint8_t subId>
+constexpr auto DecodeSampleDump = [](const std::uint8_t *bytes, std::size_t length, MidiEvent *out) -> ParseInfo {
+  constexpr std::size_t len = subId == 0x01 ? 18 : (subId == 0x02 ? 124 : 4);
+  if (length < len)
+    return {ParseInfo::E::ERROR_MSG_TOO_SHORT};
+  const ParseInfo ret = DecodeUniversal<EventType::UniversalNonRT>(bytes, length, out);
+  if constexpr (subId != 0x02)
+    out->data16 = std::uint16_t((bytes[2] & 0x7F) | (bytes[3] & 0x7F) << 7);
+  if constexpr (subId == 0x01)
+    out->value = bytes[4] & 0x7F;
+  return ret;
+};
+
+// UMP message type 0x0
+template <EventType type>
+constexpr auto DecodeUtility = [](const std::uint8_t *bytes, std::size_t, MidiEvent *out) -> ParseInfo {
+  *out = MidiEvent{type, 2, std::uint8_t(bytes[0] & 0x0F)};
+  if constexpr (type == EventType::DeltaClockstamp)
+    out->value = std::uint32_t(bytes[1] & 0x0F) << 16 | ReadBE16(bytes + 2);
+  else if constexpr (type != EventType::NOOP)
+    out->value = ReadBE16(bytes + 2);
+  return {ParseInfo::E::SUCCESS};
+};
+
+// UMP message types 0x1 & 0x2: MIDI 1.0 messages following the group byte
+template <EventType type>
+constexpr auto DecodeM1Packet = [](const std::uint8_t *bytes, std::size_t length, MidiEvent *out) -> ParseInfo {
+  const ParseInfo ret = DecodeM1<type>(bytes + 1, length - 1, out);
+  out->group = bytes[0] & 0x0F;
+  return ret;
+};
+
+// UMP message type 0x4
+template <EventType type>
+constexpr auto DecodeM2 = [](const std::uint8_t *bytes, std::size_t, MidiEvent *out) -> ParseInfo {
+  MidiEvent e{type, 2, std::uint8_t(bytes[0] & 0x0F), std::uint8_t(bytes[1] & 0x0F), bytes[2], bytes[3]};
+  if constexpr (type == EventType::NoteOff || type == EventType::NoteOn)
+    e.value = ReadBE16(bytes + 4), e.data16 = ReadBE16(bytes + 6);
+  else if constexpr (type == EventType::ProgramChange)
+    e.data1 = bytes[4] & 0x7F, e.data16 = std::uint16_t((bytes[6] & 0x7F) << 7 | (bytes[7] & 0x7F));
+  else
+    e.value = ReadBE32(bytes + 4);
+  *out = e;
+  return {ParseInfo::E::SUCCESS};
+};
+
+// UMP message type 0x3
+constexpr auto DecodeSysEx7 = [](const std::uint8_t *bytes, std::size_t, MidiEvent *out) -> ParseInfo {
+  *out = MidiEvent{EventType::SysEx7, 2, std::uint8_t(bytes[0] & 0x0F), 0, 0, std::uint8_t(bytes[1] >> 4)};
+  out->payload = bytes + 2, out->length = (bytes[1] & 0x0F) < 6 ? bytes[1] & 0x0F : 6;
+  return {ParseInfo::E::SUCCESS};
+};
+
+// UMP message type 0x5, the byte count includes the stream ID
+constexpr auto DecodeSysEx8 = [](const std::uint8_t *bytes, std::size_t, MidiEvent *out) -> ParseInfo {
+  const std::uint32_t n = (bytes[1] & 0x0F) < 14 ? bytes[1] & 0x0F : 14;
+  *out = MidiEvent{EventType::SysEx8, 2, std::uint8_t(bytes[0] & 0x0F), 0, bytes[2], std::uint8_t(bytes[1] >> 4)};
+  out->payload = bytes + 3, out->length = n ? n - 1 : 0;
+  return {ParseInfo::E::SUCCESS};
+};
+
+template <EventType type>
+constexpr auto DecodeMixedDataSet = [](const std::uint8_t *bytes, std::size_t, MidiEvent *out) -> ParseInfo {
+  *out = MidiEvent{type, 2, std::uint8_t(bytes[0] & 0x0F), 0, std::uint8_t(bytes[1] & 0x0F)};
+  out->payload = bytes + 2, out->length = 14;
+  return {ParseInfo::E::SUCCESS};
+};
+
+#endif // MIDI_DECODE_HPP
@@ -0,0 +1,253 @@
+#ifndef MIDI_DOWNCONVERT_HPP
+#define MIDI_DOWNCONVERT_HPP
+
+/**
+ * @file midi_downconvert.hpp
+ * @author Etienne SANTOUL github.com/esantoul
+ * @brief MIDI 2.0 channel voice to MIDI 1.0 byte stream conversion & value scaling
+ * @version 0.1
+ * @date 2021-02-04
+ *
+ * @copyright BSD 2-Clause License. Copyright (c) 2021, Etienne SANTOUL. All rights reserved.
+ */
+
+#include "midi_parser.hpp"
+#include "simd_config.hpp"
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Value resolution conversion between MIDI 1.0 & MIDI 2.0 (UMP specification, min-center-max scaling)
+ */
+struct ValueScale : NotInstantiable
+{
+  /**
+   * @brief Downscaling is a plain right shift
+   */
+  static constexpr std::uint32_t down(std::uint32_t value, std::uint8_t srcBits, std::uint8_t dstBits)
+  {
+    return value >> (srcBits - dstBits);
+  }
+
+  /**
+   * @brief Upscaling keeps the minimum, center & maximum values: values above the center
+   * repeat their lower bits into the added resolution
+   */
+  static constexpr std::uint32_t up(std::uint32_t value, std::uint8_t srcBits, std::uint8_t dstBits)
+  {
+    const std::uint8_t scaleBits = dstBits - srcBits;
+    std::uint32_t shifted = value << scaleBits;
+    if (value <= std::uint32_t{1} << (srcBits - 1))
+      return shifted;
+
+    const std::uint8_t repeatBits = srcBits - 1;
+    std::uint32_t repeat = value & ((std::uint32_t{1} << repeatBits) - 1);
+    if (scaleBits > repeatBits)
+      repeat <<= scaleBits - repeatBits;
+    else
+      repeat >>= repeatBits - scaleBits;
+    for (; repeat; repeat >>= repeatBits)
+      shifted |= repeat;
+    return shifted;
+  }
+
+  /**
+   * @brief Downscales full range 32-bit values to 14 bits
+   * @param values input values
+   * @param count number of values
+   * @param out output values
+   */
+  static void to14Bits(const std::uint32_t *values, std::size_t count, std::uint16_t *out)
+  {
+    std::size_t i = 0;
+#if defined(MIDI_SIMD_AVX2)
+    for (; i + 16 <= count; i += 16)
+    {
+      const __m256i a = _mm256_srli_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(values + i)), 18);
+      const __m256i b = _mm256_srli_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(values + i + 8)), 18);
+      // packs works per 128-bit lane, restore the element order afterwards
+      _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i), _mm256_permute4x64_epi64(_mm256_packs_epi32(a, b), 0xD8));
+    }
+#elif defined(MIDI_SIMD_SSE2)
+    for (; i + 8 <= count; i += 8)
+    {
+      const __m128i a = _mm_srli_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(values + i)), 18);
+      const __m128i b = _mm_srli_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(values + i + 4)), 18);
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), _mm_packs_epi32(a, b));
+    }
+#endif
+    for (; i < count; ++i)
+      out[i] = static_cast<std::uint16_t>(values[i] >> 18);
+  }
+};
+
+/**
+ * @brief Converts channel voice events into MIDI 1.0 bytes.
+ * MIDI 2.0 values are downscaled, registered & assignable controllers are expanded into RPN & NRPN
+ * control change sequences and bank selects are emitted before program changes.
+ * MIDI 1.0 events (protocol 1) are written unchanged.
+ * Relative controllers & per note messages have no MIDI 1.0 equivalent and are dropped.
+ */
+class Midi1DownConverter
+{
+public:
+  // Longest conversion output: an RPN / NRPN sequence of 4 control changes
+  static constexpr std::size_t maxSize = 12;
+
+  constexpr explicit Midi1DownConverter(bool runningStatus = false) : mRunningStatus{runningStatus} {}
+
+  constexpr void setRunningStatus(bool enabled)
+  {
+    mRunningStatus = enabled;
+    mLast = 0;
+  }
+
+  // Forget the running status, to call when the output stream is interrupted
+  constexpr void reset() { mLast = 0; }
+
+  /**
+   * @brief Converts one event
+   * @param e decoded event
+   * @param bytes output buffer
+   * @param capacity output buffer capacity
+   * @return the number of bytes written, 0 if the event has no MIDI 1.0 equivalent or does not fit
+   */
+  constexpr std::size_t convert(const MidiEvent &e, std::uint8_t *bytes, std::size_t capacity)
+  {
+    return write(e, static_cast<std::uint16_t>(normalize(e) >> 18), bytes, capacity);
+  }
+
+  /**
+   * @brief Converts a batch of events, the values are scaled in blocks with ValueScale::to14Bits
+   * @return consumed events & produced bytes. Conversion stops before the first event that does not fit
+   */
+  BatchInfo convert(const MidiEvent *events, std::size_t count, std::uint8_t *bytes, std::size_t capacity)
+  {
+    constexpr std::size_t block = 64;
+    std::uint32_t full[block];
+    std::uint16_t scaled[block];
+    std::size_t n = 0;
+    for (std::size_t i = 0; i < count; i += block)
+    {
+      const std::size_t k = count - i < block ? count - i : block;
+      for (std::size_t j = 0; j < k; ++j)
+        full[j] = normalize(events[i + j]);
+      ValueScale::to14Bits(full, k, scaled);
+
+      for (std::size_t j = 0; j < k; ++j)
+      {
+        if (!size(events[i + j]))
+          continue;
+        const std::size_t sz = write(events[i + j], scaled[j], bytes + n, capacity - n);
+        if (!sz)
+          return {i + j, n};
+        n += sz;
+      }
+    }
+    return {count, n};
+  }
+
+  /**
+   * @brief Number of bytes written for an event without running status, 0 if it has no MIDI 1.0 equivalent
+   */
+  static constexpr std::size_t size(const MidiEvent &e)
+  {
+    switch (e.type)
+    {
+    case EventType::NoteOff:
+    case EventType::NoteOn:
+    case EventType::PolyPressure:
+    case EventType::ControlChange:
+    case EventType::PitchBend:
+      return 3;
+    case EventType::ProgramChange:
+      return e.protocol == 2 && (e.data2 & 0x01) ? 8 : 2;
+    case EventType::ChannelPressure:
+      return 2;
+    case EventType::RegistCtrl:
+    case EventType::AssignCtrl:
+      return 12;
+    default:
+      return 0;
+    }
+  }
+
+private:
+  /**
+   * @brief Event value scaled to the full 32-bit range
+   */
+  static constexpr std::uint32_t normalize(const MidiEvent &e)
+  {
+    if (e.protocol == 2)
+      return e.type == EventType::NoteOn || e.type == EventType::NoteOff ? e.value << 16 : e.value;
+    return e.type == EventType::PitchBend ? e.value << 18 : e.value << 25;
+  }
+
+  constexpr std::size_t write(const MidiEvent &e, std::uint16_t v14, std::uint8_t *bytes, std::size_t capacity)
+  {
+    const std::size_t sz = size(e);
+    if (!sz)
+      return 0;
+
+    const std::uint8_t last = mLast;
+    std::uint8_t buf[maxSize]{};
+    std::size_t n = 0;
+    auto message = [&](std::uint8_t status, auto... data) {
+      if (!mRunningStatus || status != mLast)
+        buf[n++] = status;
+      mLast = status;
+      ((buf[n++] = static_cast<std::uint8_t>(data & 0x7F)), ...);
+    };
+
+    const std::uint8_t ch = e.channel & 0x0F;
+    const std::uint8_t status = static_cast<std::uint8_t>(e.type) | ch;
+    const std::uint8_t cc = static_cast<std::uint8_t>(EventType::ControlChange) | ch;
+    const std::uint8_t v7 = static_cast<std::uint8_t>(v14 >> 7);
+    switch (e.type)
+    {
+    case EventType::NoteOn:
+      // A MIDI 2.0 velocity too small for 7 bits must not turn into a note off
+      message(status, e.data1, e.protocol == 2 && !v7 ? 1 : v7);
+      break;
+    case EventType::NoteOff:
+    case EventType::PolyPressure:
+    case EventType::ControlChange:
+      message(status, e.data1, v7);
+      break;
+    case EventType::ProgramChange:
+      if (sz == 8)
+        message(cc, 0, e.data16 >> 7), message(cc, 32, e.data16);
+      message(status, e.data1);
+      break;
+    case EventType::ChannelPressure:
+      message(status, v7);
+      break;
+    case EventType::PitchBend:
+      message(status, v14, v14 >> 7);
+      break;
+    default: // RegistCtrl, AssignCtrl
+    {
+      const bool rpn = e.type == EventType::RegistCtrl;
+      message(cc, rpn ? 101 : 99, e.data1);
+      message(cc, rpn ? 100 : 98, e.data2);
+      message(cc, 6, v7);
+      message(cc, 38, v14);
+      break;
+    }
+    }
+
+    if (n > capacity)
+    {
+      mLast = last;
+      return 0;
+    }
+    for (std::size_t i = 0; i < n; ++i)
+      bytes[i] = buf[i];
+    return n;
+  }
+
+  bool mRunningStatus;
+  std::uint8_t mLast{};
+};
+
+#endif // MIDI_DOWNCONVERT_HPP
@@ -0,0 +1,378 @@
+#ifndef MIDI_ENCODE_HPP
+#define MIDI_ENCODE_HPP
+
+/**
+ * @file midi_encode.hpp
+ * @author Etienne SANTOUL github.com/esantoul
+ * @brief MidiEvent encoding into MIDI 1.0 bytes & Universal MIDI Packets, the inverse of midi_decode.hpp
+ * @version 0.1
+ * @date 2021-02-04
+ *
+ * @copyright BSD 2-Clause License. Copyright (c) 2021, Etienne SANTOUL. All rights reserved.
+ */
+
+#include "midi_decode.hpp"
+#include "midi_parser.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Encodes events with the field layout produced by the MidiBytes leaves (see MidiEvent).
+ * MIDI 1.0 encoding takes protocol 1 events, use Midi1DownConverter for MIDI 2.0 values.
+ * UMP encoding picks the message type from the event: protocol 1 channel voice & system events
+ * become MIDI 1.0 Channel Voice & System packets, protocol 1 SysEx becomes a Data64 SysEx7 sequence.
+ */
+struct MidiEncode : NotInstantiable
+{
+  /**
+   * @brief Size of the MIDI 1.0 message of an event (SysEx includes F0 & F7), 0 if it has none
+   */
+  static constexpr std::size_t m1Size(const MidiEvent &e)
+  {
+    if (e.protocol != 1)
+      return 0;
+    if (isSysEx(e.type))
+      return e.length + 2;
+    if (e.type < EventType::NoteOff)
+      return 0;
+    const MidiSize sz = MidiBytes::M1::insight(static_cast<std::uint8_t>(e.type));
+    return sz.status() == MidiSize::Status::Set ? sz.value() : 0;
+  }
+
+  /**
+   * @brief Writes the MIDI 1.0 message of an event
+   * @param e protocol 1 event
+   * @param out output, at least m1Size(e) bytes
+   * @return the number of bytes written, 0 if the event has no MIDI 1.0 message
+   */
+  static constexpr std::size_t m1(const MidiEvent &e, std::uint8_t *out)
+  {
+    const std::size_t len = m1Size(e);
+    if (!len)
+      return 0;
+
+    if (isSysEx(e.type))
+    {
+      out[0] = 0xF0;
+      for (std::size_t i = 0; i < e.length; ++i)
+        out[i + 1] = e.payload[i] & 0x7F;
+      out[len - 1] = 0xF7;
+      return len;
+    }
+
+    const bool valueFirst = e.type == EventType::ChannelPressure || e.type == EventType::PitchBend || e.type == EventType::SongPos;
+    out[0] = static_cast<std::uint8_t>(e.type) | (e.type < EventType::SysEx ? e.channel & 0x0F : 0);
+    if (len > 1)
+      out[1] = (valueFirst ? e.value : e.data1) & 0x7F;
+    if (len > 2)
+      out[2] = (valueFirst ? e.value >> 7 : e.value) & 0x7F;
+    return len;
+  }
+
+  /**
+   * @brief Number of UMP words of an event, 0 if it has no UMP representation
+   */
+  static constexpr std::size_t umpSize(const MidiEvent &e)
+  {
+    if (e.protocol == 1)
+    {
+      if (isSysEx(e.type))
+        return e.length ? 2 * ((e.length + 5) / 6) : 2;
+      return m1Size(e) ? 1 : 0;
+    }
+    return words(e.type);
+  }
+
+  /**
+   * @brief Writes the Universal MIDI Packets of an event
+   * @param e event
+   * @param out output, at least umpSize(e) words
+   * @return the number of words written, 0 if the event has no UMP representation
+   */
+  static constexpr std::size_t ump(const MidiEvent &e, std::uint32_t *out)
+  {
+    const std::size_t n = umpSize(e);
+    if (!n)
+      return 0;
+    if (e.protocol == 1 && isSysEx(e.type))
+      return sysex7(e, out);
+
+    std::uint8_t b[16]{};
+    packet(e, b);
+    for (std::size_t i = 0; i < n; ++i)
+      out[i] = ReadBE32(b + 4 * i);
+    return n;
+  }
+
+  // Compile-time builders
+
+  /**
+   * @brief MIDI 1.0 message as a byte array, e.g. `MidiEncode::m1<EventType::NoteOn>(0, 60, 100)`
+   * @param channel channel of channel voice messages
+   * @param data1 note, controller, program, MTC quarter frame or song
+   * @param value velocity, pressure, controller value, 14-bit pitch bend or song position
+   */
+  template <EventType type>
+  static constexpr auto m1(std::uint8_t channel = 0, std::uint8_t data1 = 0, std::uint32_t value = 0)
+  {
+    static_assert(type >= EventType::NoteOff && !isSysEx(type), "not a fixed size MIDI 1.0 message");
+    std::array<std::uint8_t, MidiBytes::M1::insight(static_cast<std::uint8_t>(type)).value()> bytes{};
+    MidiEvent e{type, 1, 0, channel, data1};
+    e.value = value;
+    m1(e, bytes.data());
+    return bytes;
+  }
+
+  /**
+   * @brief Universal MIDI Packet as a word array, e.g. `MidiEncode::ump<EventType::NoteOn>({{}, {}, group, channel, note, 0, 0, velocity16})`
+   * @tparam protocol 1 for MIDI 1.0 Channel Voice & System packets, 2 for MIDI 2.0 Channel Voice packets
+   */
+  template <EventType type, std::uint8_t protocol = 2>
+  static constexpr auto ump(MidiEvent e)
+  {
+    static_assert(!isSysEx(type), "MIDI 1.0 SysEx has no fixed UMP size");
+    e.type = type;
+    e.protocol = protocol;
+    std::array<std::uint32_t, umpSize(MidiEvent{type, protocol})> words{};
+    ump(e, words.data());
+    return words;
+  }
+
+private:
+  static constexpr bool isSysEx(EventType t) { return t == EventType::SysEx || t == EventType::UniversalNonRT || t == EventType::UniversalRT; }
+
+  // Packet words of the UMP only event types & of protocol 2 channel voice events
+  static constexpr std::size_t words(EventType t)
+  {
+    switch (t)
+    {
+    case EventType::NOOP:
+    case EventType::JRClock:
+    case EventType::JRTimestamp:
+    case EventType::DeltaClockstampTPQ:
+    case EventType::DeltaClockstamp:
+      return 1;
+    case EventType::SysEx7:
+      return 2;
+    case EventType::SysEx8:
+    case EventType::MixedDataSetHeader:
+    case EventType::MixedDataSetPayload:
+      return 4;
+    default:
+      return (t >= EventType::RegistPerNoteCtrl && t <= EventType::PerNoteManagement) || (t >= EventType::NoteOff && t < EventType::SysEx) ? 2 : 0;
+    }
+  }
+
+  // UMP status byte (second byte) of the MidiBytes::M2 leaves
+  static constexpr std::uint8_t status(EventType t)
+  {
+    using U = MidiBytes::M2::Utility;
+    using C = MidiBytes::M2::Midi2Channel;
+    using D = MidiBytes::M2::Data128Bits;
+    switch (t)
+    {
+    case EventType::NOOP: return U::NOOP::value;
+    case EventType::JRClock: return U::JRClock::value;
+    case EventType::JRTimestamp: return U::JRTimestamp::value;
+    case EventType::DeltaClockstampTPQ: return U::DeltaClockstampTPQ::value;
+    case EventType::DeltaClockstamp: return U::DeltaClockstamp::value;
+    case EventType::RegistPerNoteCtrl: return C::RegistPerNoteCtrl::value;
+    case EventType::AssignPerNoteCtrl: return C::AssignPerNoteCtrl::value;
+    case EventType::RegistCtrl: return C::RegistCtrl::value;
+    case EventType::AssignCtrl: return C::AssignCtrl::value;
+    case EventType::RelativeRegistCtrl: return C::RelativeRegistCtrl::value;
+    case EventType::RelativeAssignCtrl: return C::RelativeAssignCtrl::value;
+    case EventType::PerNotePitchBend: return C::PerNotePitchBend::value;
+    case EventType::PerNoteManagement: return C::PerNoteManagement::value;
+    case EventType::MixedDataSetHeader: return D::MixedDataSetHeader::value;
+    case EventType::MixedDataSetPayload: return D::MixedDataSetPayload::value;
+    default: return static_cast<std::uint8_t>(t);
+    }
+  }
+
+  // Single packet, same byte layout as the decode tasks
+  static constexpr void packet(const MidiEvent &e, std::uint8_t *b)
+  {
+    const std::uint8_t group = e.group & 0x0F;
+    if (e.protocol == 1)
+    {
+      b[0] = (e.type < EventType::SysEx ? MidiBytes::M2::Midi1Channel::value : MidiBytes::M2::System::value) | group;
+      m1(e, b + 1);
+      return;
+    }
+
+    switch (e.type)
+    {
+    case EventType::NOOP:
+    case EventType::JRClock:
+    case EventType::JRTimestamp:
+    case EventType::DeltaClockstampTPQ:
+    case EventType::DeltaClockstamp:
+      b[0] = MidiBytes::M2::Utility::value | group;
+      b[1] = status(e.type) | (e.type == EventType::DeltaClockstamp ? (e.value >> 16) & 0x0F : 0);
+      b[2] = std::uint8_t(e.value >> 8), b[3] = std::uint8_t(e.value);
+      return;
+    case EventType::SysEx7:
+    {
+      const std::uint32_t n = e.length < 6 ? e.length : 6;
+      b[0] = MidiBytes::M2::Data64Bits::value | group;
+      b[1] = std::uint8_t(e.data2 << 4 | n);
+      for (std::size_t i = 0; i < n; ++i)
+        b[2 + i] = e.payload[i] & 0x7F;
+      return;
+    }
+    case EventType::SysEx8:
+    {
+      const std::uint32_t n = e.length < 13 ? e.length : 13;
+      b[0] = MidiBytes::M2::Data128Bits::value | group;
+      b[1] = std::uint8_t(e.data2 << 4 | (n + 1));
+      b[2] = e.data1;
+      for (std::size_t i = 0; i < n; ++i)
+        b[3 + i] = e.payload[i];
+      return;
+    }
+    case EventType::MixedDataSetHeader:
+    case EventType::MixedDataSetPayload:
+      b[0] = MidiBytes::M2::Data128Bits::value | group;
+      b[1] = status(e.type) | (e.data1 & 0x0F);
+      for (std::size_t i = 0; i < 14 && i < e.length; ++i)
+        b[2 + i] = e.payload[i];
+      return;
+    default:
+      break;
+    }
+
+    // MIDI 2.0 channel voice
+    b[0] = MidiBytes::M2::Midi2Channel::value | group;
+    b[1] = status(e.type) | (e.channel & 0x0F);
+    b[2] = e.data1, b[3] = e.data2;
+    if (e.type == EventType::NoteOff || e.type == EventType::NoteOn)
+    {
+      b[4] = std::uint8_t(e.value >> 8), b[5] = std::uint8_t(e.value);
+      b[6] = std::uint8_t(e.data16 >> 8), b[7] = std::uint8_t(e.data16);
+    }
+    else if (e.type == EventType::ProgramChange)
+    {
+      b[2] = 0, b[4] = e.data1 & 0x7F;
+      b[6] = (e.data16 >> 7) & 0x7F, b[7] = e.data16 & 0x7F;
+    }
+    else
+      b[4] = std::uint8_t(e.value >> 24), b[5] = std::uint8_t(e.value >> 16), b[6] = std::uint8_t(e.value >> 8), b[7] = std::uint8_t(e.value);
+  }
+
+  // MIDI 1.0 SysEx body as a Data64 SysEx7 packet sequence
+  static constexpr std::size_t sysex7(const MidiEvent &e, std::uint32_t *out)
+  {
+    using D = MidiBytes::M2::Data64Bits;
+    std::size_t n = 0;
+    std::size_t pos = 0;
+    do
+    {
+      const std::size_t chunk = e.length - pos < 6 ? e.length - pos : 6;
+      const bool first = pos == 0;
+      const bool last = pos + chunk == e.length;
+      const std::uint8_t st = first ? (last ? D::SysEx1Packet::value : D::SysExStart::value) : (last ? D::SysExEnd::value : D::SysExContinue::value);
+
+      std::uint8_t b[8]{std::uint8_t(D::value | (e.group & 0x0F)), std::uint8_t(st | chunk)};
+      for (std::size_t i = 0; i < chunk; ++i)
+        b[2 + i] = e.payload[pos + i] & 0x7F;
+      out[n++] = ReadBE32(b);
+      out[n++] = ReadBE32(b + 4);
+      pos += chunk;
+    } while (pos < e.length);
+    return n;
+  }
+};
+
+/**
+ * @brief Appends MIDI 1.0 messages to a caller buffer, with optional running status compression
+ */
+class MidiEncoder
+{
+public:
+  constexpr MidiEncoder(std::uint8_t *bytes, std::size_t capacity, bool runningStatus = false)
+    : mBytes{bytes}, mCapacity{capacity}, mRunningStatus{runningStatus}
+  {
+  }
+
+  /**
+   * @brief Appends an event
+   * @return false if the event has no MIDI 1.0 message or does not fit (nothing is written)
+   */
+  constexpr bool append(const MidiEvent &e)
+  {
+    std::size_t len = MidiEncode::m1Size(e);
+    if (!len || len > mCapacity - mSize)
+      return false;
+
+    // Running status only covers channel voice messages, SysEx & system common cancel it, realtime leaves it untouched
+    if (e.type >= EventType::NoteOff && e.type < EventType::SysEx)
+    {
+      const std::uint8_t st = static_cast<std::uint8_t>(static_cast<std::uint8_t>(e.type) | (e.channel & 0x0F));
+      if (mRunningStatus && st == mLast)
+      {
+        std::uint8_t m[3]{};
+        MidiEncode::m1(e, m);
+        for (std::size_t i = 1; i < len; ++i)
+          mBytes[mSize + i - 1] = m[i];
+        mSize += len - 1;
+        return true;
+      }
+      mLast = st;
+    }
+    else if (e.type < EventType::TimingClock)
+      mLast = 0;
+
+    MidiEncode::m1(e, mBytes + mSize);
+    mSize += len;
+    return true;
+  }
+
+  constexpr std::size_t size() const { return mSize; }
+
+  constexpr void clear()
+  {
+    mSize = 0;
+    mLast = 0;
+  }
+
+private:
+  std::uint8_t *mBytes;
+  std::size_t mCapacity;
+  std::size_t mSize{};
+  bool mRunningStatus;
+  std::uint8_t mLast{};
+};
+
+/**
+ * @brief Appends Universal MIDI Packets to a caller word buffer
+ */
+class UmpEncoder
+{
+public:
+  constexpr UmpEncoder(std::uint32_t *words, std::size_t capacity) : mWords{words}, mCapacity{capacity} {}
+
+  /**
+   * @brief Appends an event
+   * @return false if the event has no UMP representation or does not fit (nothing is written)
+   */
+  constexpr bool append(const MidiEvent &e)
+  {
+    const std::size_t n = MidiEncode::umpSize(e);
+    if (!n || n > mCapacity - mSize)
+      return false;
+    mSize += MidiEncode::ump(e, mWords + mSize);
+    return true;
+  }
+
+  constexpr std::size_t size() const { return mSize; }
+  constexpr void clear() { mSize = 0; }
+
+private:
+  std::uint32_t *mWords;
+  std::size_t mCapacity;
+  std::size_t mSize{};
+};
+
+#endif // MIDI_ENCODE_HPP
@@ -0,0 +1,121 @@
+#ifndef MIDI_EVENT_HPP
+#define MIDI_EVENT_HPP
+
+/**
+ * @file midi_event.hpp
+ * @author Etienne SANTOUL github.com/esantoul
+ * @brief Decoded MIDI event type, the output of MidiBytes::Interpret
+ * @version 0.1
+ * @date 2021-02-04
+ *
+ * @copyright BSD 2-Clause License. Copyright (c) 2021, Etienne SANTOUL. All rights reserved.
+ */
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Decoded message type.
+ * Channel voice types equal their MIDI 1.0 status nibble and system types their MIDI 1.0 status byte,
+ * so `type | channel` is the MIDI 1.0 status byte of a channel voice event.
+ */
+enum class EventType : std::uint8_t
+{
+  None = 0x00,
+
+  // UMP Utility
+  NOOP = 0x01,
+  JRClock = 0x02,
+  JRTimestamp = 0x03,
+  DeltaClockstampTPQ = 0x04,
+  DeltaClockstamp = 0x05,
+
+  // MIDI 2.0 only channel voice
+  RegistPerNoteCtrl = 0x10,
+  AssignPerNoteCtrl = 0x11,
+  RegistCtrl = 0x12,
+  AssignCtrl = 0x13,
+  RelativeRegistCtrl = 0x14,
+  RelativeAssignCtrl = 0x15,
+  PerNotePitchBend = 0x16,
+  PerNoteManagement = 0x1F,
+
+  // UMP data packets
+  SysEx7 = 0x30,
+  SysEx8 = 0x50,
+  MixedDataSetHeader = 0x58,
+  MixedDataSetPayload = 0x59,
+
+  // MIDI 1.0 Universal SysEx
+  UniversalNonRT = 0x7E,
+  UniversalRT = 0x7F,
+
+  // Channel voice
+  NoteOff = 0x80,
+  NoteOn = 0x90,
+  PolyPressure = 0xA0,
+  ControlChange = 0xB0,
+  ProgramChange = 0xC0,
+  ChannelPressure = 0xD0,
+  PitchBend = 0xE0,
+
+  // System
+  SysEx = 0xF0,
+  MTC = 0xF1,
+  SongPos = 0xF2,
+  SongSel = 0xF3,
+  TuneRequest = 0xF6,
+  TimingClock = 0xF8,
+  Start = 0xFA,
+  Continue = 0xFB,
+  Stop = 0xFC,
+  ActiveSensing = 0xFE,
+  Reset = 0xFF,
+};
+
+/**
+ * @brief A decoded MIDI 1.0 message or Universal MIDI Packet (24 bytes, trivially copyable).
+ *
+ * Field usage per type:
+ * | type                                     | data1        | data2             | data16         | value / payload & length      |
+ * |------------------------------------------|--------------|-------------------|----------------|-------------------------------|
+ * | NoteOff, NoteOn                          | note         | attribute type    | attribute      | velocity (7 or 16 bits)       |
+ * | PolyPressure                             | note         |                   |                | pressure (7 or 32 bits)       |
+ * | ControlChange                            | controller   |                   |                | value (7 or 32 bits)          |
+ * | ProgramChange                            | program      | option flags      | bank (14 bits) |                               |
+ * | ChannelPressure                          |              |                   |                | pressure (7 or 32 bits)       |
+ * | PitchBend                                |              |                   |                | bend (14 or 32 bits)          |
+ * | RegistPerNoteCtrl, AssignPerNoteCtrl     | note         | controller        |                | value (32 bits)               |
+ * | RegistCtrl, AssignCtrl, Relative*Ctrl    | bank         | index             |                | value (32 bits)               |
+ * | PerNotePitchBend                         | note         |                   |                | bend (32 bits)                |
+ * | PerNoteManagement                        | note         | option flags      |                |                               |
+ * | MTC                                      | quarter frame|                   |                |                               |
+ * | SongPos                                  |              |                   |                | position (14 bits)            |
+ * | SongSel                                  | song         |                   |                |                               |
+ * | JRClock, JRTimestamp                     |              |                   |                | time (16 bits)                |
+ * | DeltaClockstampTPQ                       |              |                   |                | ticks per quarter (16 bits)   |
+ * | DeltaClockstamp                          |              |                   |                | ticks since last (20 bits)    |
+ * | SysEx                                    | first ID byte|                   |                | payload = body without F0/F7  |
+ * | UniversalNonRT, UniversalRT              | device ID    | sub-ID#1          | sub-ID#2       | payload = body without F0/F7  |
+ * | UniversalNonRT sample dump (sub-ID#1 1-3)| device ID    | sub-ID#1          | sample/packet #| format (headers) & payload    |
+ * | SysEx7                                   |              | packet status     |                | payload = packet data bytes   |
+ * | SysEx8                                   | stream ID    | packet status     |                | payload = packet data bytes   |
+ * | MixedDataSetHeader, MixedDataSetPayload  | MDS ID       |                   |                | payload = packet data bytes   |
+ *
+ * `payload` points into the buffer given to MidiBytes::Interpret and is only valid as long as that buffer is.
+ */
+struct MidiEvent
+{
+  EventType type{};
+  std::uint8_t protocol{}; // 1: MIDI 1.0 value resolution, 2: MIDI 2.0 value resolution
+  std::uint8_t group{};    // UMP group, 0 for MIDI 1.0 byte streams
+  std::uint8_t channel{};
+  std::uint8_t data1{};
+  std::uint8_t data2{};
+  std::uint16_t data16{};
+  std::uint32_t value{};
+  std::uint32_t length{};
+  const std::uint8_t *payload{};
+};
+
+#endif // MIDI_EVENT_HPP
@@ -0,0 +1,267 @@
+#ifndef MIDI_FILTER_HPP
+#define MIDI_FILTER_HPP
+
+/**
+ * @file midi_filter.hpp
+ * @author Etienne SANTOUL github.com/esantoul
+ * @brief Message filtering on framed MIDI 1.0 messages & UMP packets, before decoding
+ * @version 0.1
+ * @date 2021-02-04
+ *
+ * @copyright BSD 2-Clause License. Copyright (c) 2021, Etienne SANTOUL. All rights reserved.
+ */
+
+#include "midi_batch.hpp"
+#include "midi_parser.hpp"
+#include "simd_config.hpp"
+#include "ump_stream.hpp"
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Filter configuration compiled into lookup tables:
+ * a 256-bit mask of the MIDI 1.0 status bytes that pass, and for UMP a group mask & a channel mask per message type
+ * & status nibble (opcode, SysEx status or low nibble of the system status byte). Channel masks only apply to the
+ * channel voice message types (0x2 & 0x4).
+ * A message passes with one table lookup & two bit tests, so filtering happens right after framing.
+ */
+class MidiFilter
+{
+public:
+  constexpr explicit MidiFilter(bool pass = true)
+  {
+    if (pass)
+      passAll();
+    else
+      blockAll();
+  }
+
+  constexpr void passAll()
+  {
+    for (auto &w : mStatus)
+      w = ~std::uint64_t{0};
+    for (auto &e : mUmp)
+      e = 0xFFFFFFFF;
+  }
+
+  constexpr void blockAll()
+  {
+    for (auto &w : mStatus)
+      w = 0;
+    for (auto &e : mUmp)
+      e = 0;
+  }
+
+  /**
+   * @brief Sets whether a MIDI 1.0 status byte passes
+   */
+  constexpr void setStatus(std::uint8_t status, bool pass)
+  {
+    const std::uint64_t bit = std::uint64_t{1} << (status & 63);
+    mStatus[status >> 6] = pass ? mStatus[status >> 6] | bit : mStatus[status >> 6] & ~bit;
+  }
+
+  /**
+   * @brief Sets whether MIDI 1.0 messages of a channel voice type pass on the channels of a mask
+   * @param type NoteOff to PitchBend
+   * @param channels bit c for channel c
+   */
+  constexpr void setChannelVoice(EventType type, std::uint16_t channels, bool pass)
+  {
+    for (std::uint8_t c = 0; c < 16; ++c)
+      if (channels >> c & 1)
+        setStatus(static_cast<std::uint8_t>(static_cast<std::uint8_t>(type) | c), pass);
+  }
+
+  /**
+   * @brief Sets the groups & channels for which UMP packets of a message type & status pass
+   * @param messageType message type (first nibble)
+   * @param status opcode or status nibble (second byte high nibble), low nibble of the status byte for system messages
+   * @param groups bit g for group g, 0 blocks the packets
+   * @param channels bit c for channel c, ignored for message types without a channel
+   */
+  constexpr void setUmp(std::uint8_t messageType, std::uint8_t status, std::uint16_t groups, std::uint16_t channels = 0xFFFF)
+  {
+    const bool channelVoice = messageType == 0x2 || messageType == 0x4;
+    mUmp[(messageType & 0x0F) << 4 | (status & 0x0F)] = std::uint32_t(channelVoice ? channels : 0xFFFF) << 16 | groups;
+  }
+
+  // Sets every status of a message type
+  constexpr void setUmpType(std::uint8_t messageType, std::uint16_t groups, std::uint16_t channels = 0xFFFF)
+  {
+    for (std::uint8_t s = 0; s < 16; ++s)
+      setUmp(messageType, s, groups, channels);
+  }
+
+  /**
+   * @brief Sets a channel voice type shared by MIDI 1.0 (message type 0x2) & MIDI 2.0 (message type 0x4) packets
+   * @param type NoteOff to PitchBend
+   */
+  constexpr void setUmpChannelVoice(EventType type, std::uint16_t groups, std::uint16_t channels)
+  {
+    setUmp(0x2, static_cast<std::uint8_t>(type) >> 4, groups, channels);
+    setUmp(0x4, static_cast<std::uint8_t>(type) >> 4, groups, channels);
+  }
+
+  // @param status first byte of a framed MIDI 1.0 message
+  constexpr bool pass(std::uint8_t status) const { return mStatus[status >> 6] >> (status & 63) & 1; }
+
+  // @param word first word of a UMP packet
+  constexpr bool pass(std::uint32_t word) const
+  {
+    const std::uint32_t mt = word >> 28;
+    const std::uint32_t e = mUmp[mt << 4 | (word >> (mt == 0x1 ? 16 : 20) & 0x0F)];
+    return (e >> (word >> 24 & 0x0F)) & (e >> (16 + (word >> 16 & 0x0F))) & 1;
+  }
+
+  /**
+   * @brief MidiBytes::InterpretBatch decoding only the messages that pass. Messages sent with running status are filtered
+   * on it, interleaved realtime bytes on their own status
+   * @param running running status, carried from one call to the next
+   * @return consumed bytes & produced events
+   */
+  constexpr BatchInfo interpretBatch(const std::uint8_t *bytes, std::size_t length, MidiEvent *events, std::size_t capacity, std::uint8_t &running) const
+  {
+    std::size_t pos = 0;
+    std::size_t n = 0;
+    while (pos < length)
+    {
+      const std::uint8_t prev = running;
+      const M1Framing::Unit u = M1Framing::next(bytes, length, pos, running);
+      const bool message = u.kind == M1Framing::Unit::Kind::Message || u.kind == M1Framing::Unit::Kind::SysEx;
+      if (u.kind == M1Framing::Unit::Kind::Incomplete || n + M1Framing::realtime(bytes, pos, u.end) + message > capacity)
+      {
+        running = prev;
+        break;
+      }
+
+      for (std::size_t i = pos; i < u.end; ++i)
+        if (bytes[i] >= 0xF8 && pass(bytes[i]))
+          n += MidiBytes::Interpret(bytes + i, 1, events + n).status() == ParseInfo::E::SUCCESS;
+      if (u.kind == M1Framing::Unit::Kind::Message && pass(u.message[0]))
+        n += MidiBytes::Interpret(u.message, u.length, events + n).status() == ParseInfo::E::SUCCESS;
+      else if (u.kind == M1Framing::Unit::Kind::SysEx && pass(std::uint8_t{0xF0}))
+        n += MidiBytes::Interpret(bytes + pos, u.end - pos, events + n).status() == ParseInfo::E::SUCCESS;
+      pos = u.end;
+    }
+    return {pos, n};
+  }
+
+  constexpr BatchInfo interpretBatch(const std::uint8_t *bytes, std::size_t length, MidiEvent *events, std::size_t capacity) const
+  {
+    std::uint8_t running = 0;
+    return interpretBatch(bytes, length, events, capacity, running);
+  }
+
+  /**
+   * @brief MidiBytes::InterpretWords decoding only the packets that pass
+   * @return consumed words & produced events
+   */
+  constexpr BatchInfo interpretWords(const std::uint32_t *words, std::size_t count, MidiEvent *events, std::size_t capacity) const
+  {
+    std::size_t pos = 0;
+    std::size_t n = 0;
+    while (pos < count && n < capacity)
+    {
+      const std::size_t sz = UmpFraming::packetWords(words[pos]);
+      if (pos + sz > count)
+        break;
+      if (pass(words[pos]))
+      {
+        std::uint8_t packet[16]{};
+        UmpFraming::toBytes(words + pos, sz, packet);
+        if (MidiBytes::M2::method(packet, 4 * sz, events + n).status() == ParseInfo::E::SUCCESS)
+          events[n++].payload = nullptr;
+      }
+      pos += sz;
+    }
+    return {pos, n};
+  }
+
+  /**
+   * @brief Copies the complete messages that pass, running status & interleaved realtime bytes kept as sent.
+   * Messages sent with running status share the filtering of the message that set it, so the output stays well formed
+   * @param out output buffer, at least `length` bytes (filtering may happen in place)
+   * @param running running status, carried from one call to the next
+   * @return consumed & written bytes. A trailing incomplete message is left for the next call
+   */
+  constexpr BatchInfo filterBytes(const std::uint8_t *bytes, std::size_t length, std::uint8_t *out, std::uint8_t &running) const
+  {
+    std::size_t pos = 0;
+    std::size_t n = 0;
+    while (pos < length)
+    {
+      const std::uint8_t prev = running;
+      const M1Framing::Unit u = M1Framing::next(bytes, length, pos, running);
+      if (u.kind == M1Framing::Unit::Kind::Incomplete)
+      {
+        running = prev;
+        break;
+      }
+      const bool keep = (u.kind == M1Framing::Unit::Kind::Message && pass(u.message[0])) ||
+                        (u.kind == M1Framing::Unit::Kind::SysEx && pass(std::uint8_t{0xF0}));
+      for (; pos < u.end; ++pos)
+        if (bytes[pos] >= 0xF8 ? pass(bytes[pos]) : keep)
+          out[n++] = bytes[pos];
+    }
+    return {pos, n};
+  }
+
+  constexpr BatchInfo filterBytes(const std::uint8_t *bytes, std::size_t length, std::uint8_t *out) const
+  {
+    std::uint8_t running = 0;
+    return filterBytes(bytes, length, out, running);
+  }
+
+  /**
+   * @brief Copies the complete packets that pass. Runs of single word packets are filtered 8 words at a time with AVX2
+   * @param out output buffer, at least `count` words (filtering may happen in place)
+   * @return consumed & written words. A trailing incomplete packet is left for the next call
+   */
+  BatchInfo filterWords(const std::uint32_t *words, std::size_t count, std::uint32_t *out) const
+  {
+    std::size_t pos = 0;
+    std::size_t n = 0;
+    while (pos < count)
+    {
+#if defined(MIDI_SIMD_AVX2)
+      if (count - pos >= 8)
+      {
+        const __m256i w = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(words + pos));
+        const __m256i one = _mm256_set1_epi32(1);
+        const __m256i nibble = _mm256_set1_epi32(0x0F);
+        const __m256i mt = _mm256_srli_epi32(w, 28);
+        // Message types 0x0, 0x1, 0x2, 0x6 & 0x7 are single words
+        const __m256i single = _mm256_and_si256(_mm256_srlv_epi32(_mm256_set1_epi32(0xC7), mt), one);
+        if (_mm256_movemask_epi8(_mm256_cmpeq_epi32(single, one)) == -1)
+        {
+          const __m256i shift = _mm256_blendv_epi8(_mm256_set1_epi32(20), _mm256_set1_epi32(16), _mm256_cmpeq_epi32(mt, one));
+          const __m256i idx = _mm256_or_si256(_mm256_slli_epi32(mt, 4), _mm256_and_si256(_mm256_srlv_epi32(w, shift), nibble));
+          const __m256i e = _mm256_i32gather_epi32(reinterpret_cast<const int *>(mUmp), idx, 4);
+          const __m256i grp = _mm256_and_si256(_mm256_srli_epi32(w, 24), nibble);
+          const __m256i ch = _mm256_add_epi32(_mm256_and_si256(_mm256_srli_epi32(w, 16), nibble), _mm256_set1_epi32(16));
+          const __m256i keep = _mm256_and_si256(_mm256_and_si256(_mm256_srlv_epi32(e, grp), _mm256_srlv_epi32(e, ch)), one);
+          for (unsigned mask = static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(keep, one)))); mask; mask &= mask - 1)
+            out[n++] = words[pos + __builtin_ctz(mask)];
+          pos += 8;
+          continue;
+        }
+      }
+#endif
+      const std::size_t sz = UmpFraming::packetWords(words[pos]);
+      if (pos + sz > count)
+        break;
+      if (pass(words[pos]))
+        for (std::size_t i = 0; i < sz; ++i)
+          out[n++] = words[pos + i];
+      pos += sz;
+    }
+    return {pos, n};
+  }
+
+private:
+  std::uint64_t mStatus[4]{};
+  std::uint32_t mUmp[256]{}; // channels << 16 | groups, indexed by message type << 4 | status
+};
+
+#endif // MIDI_FILTER_HPP
@@ -12,7 +12,9 @@
  */
 
 #include "info_types.hpp"
+#include "midi_event.hpp"
 #include "../include/pgm.hpp"
+#include <array>
 #include <cstddef>
 #include <cstdint>
 
@@ -32,7 +34,54 @@ public:
     return SizeHelper<Proto_t, CaseTuple_t>(cf, df, std::make_index_sequence<std::tuple_size_v<CaseTuple_t>>());
   }
 
+  // Flattened dispatch: one Proto_t function pointer per byte value, calling the method of the case matching (byte & mask) or the default
+  template <typename Proto_t, typename CaseTuple_t, std::uint8_t mask, typename Default_t>
+  static constexpr auto Table(Default_t df)
+  {
+    return TableHelper<Proto_t, CaseTuple_t, mask>(df, std::make_index_sequence<std::tuple_size_v<CaseTuple_t>>());
+  }
+
+  // Insight results for every byte value
+  template <typename Insight_t>
+  static constexpr auto SizeTable(const Insight_t &insight)
+  {
+    std::array<decltype(insight(std::uint8_t{})), 256> table{};
+    for (std::size_t b = 0; b < table.size(); ++b)
+      table[b] = insight(static_cast<std::uint8_t>(b));
+    return table;
+  }
+
+  // Replaces the entries of base for which (byte & mask) == value by the entries of sub
+  template <typename Entry_t>
+  static constexpr std::array<Entry_t, 256> Overlay(std::array<Entry_t, 256> base, const std::array<Entry_t, 256> &sub, std::uint8_t value, std::uint8_t mask)
+  {
+    for (std::size_t b = 0; b < base.size(); ++b)
+      if ((b & mask) == value)
+        base[b] = sub[b];
+    return base;
+  }
+
 private:
+  template <typename Proto_t, typename Case_t>
+  struct Caller;
+  template <typename Ret_t, typename... Args_t, typename Case_t>
+  struct Caller<Ret_t(Args_t...), Case_t>
+  {
+    static constexpr Ret_t call(Args_t... args) { return Case_t::method(args...); }
+  };
+
+  template <typename Proto_t, typename CaseTuple_t, std::uint8_t mask, typename Default_t, std::size_t... case_idx>
+  static constexpr auto TableHelper(Default_t df, std::index_sequence<case_idx...>)
+  {
+    std::array<Proto_t *, 256> table{};
+    for (std::size_t b = 0; b < table.size(); ++b)
+      table[b] = df;
+    // Plain assignments: testing the function pointers as booleans is not a constant expression with every compiler flag
+    for (std::size_t b = 0; b < table.size(); ++b)
+      ((void)(((b & mask) == std::tuple_element_t<case_idx, CaseTuple_t>::value) ? (table[b] = &Caller<Proto_t, std::tuple_element_t<case_idx, CaseTuple_t>>::call, 0) : 0), ...);
+    return table;
+  }
+
   template <typename Proto_t, typename CaseTuple_t, typename CondFun_t, typename Default_t, std::size_t... case_idx>
   static constexpr auto ParseHelper(CondFun_t cf, Default_t df, std::index_sequence<case_idx...>)
   {
@@ -71,6 +120,13 @@ enum class PARSE_STATUS
 
 using ParseInfo = utils::info<PARSE_STATUS>;
 
+// Result of a batch interpretation
+struct BatchInfo
+{
+  std::size_t consumed; // input bytes (or words) consumed, a trailing incomplete message is left unconsumed
+  std::size_t produced; // events written
+};
+
 class MidiSize
 {
 public:
@@ -101,18 +157,12 @@ public:
 
   constexpr Status status() const
   {
-    if (mVal != 0 && mVal <= 16)
+    // Unsigned wrap-around turns each range test into a single comparison
+    if (std::uint8_t(mVal - 1) < 16)
       return Status::Set;
-    else if (mVal >= 0x81 && mVal <= 0x90)
+    else if (std::uint8_t(mVal - 0x81) < 16)
       return Status::Discard;
-    switch (mVal)
-    {
-    case 0x00:
-      return Status::Error;
-    case 0xF7:
-      return Status::SysEx;
-    }
-    return Status::Error;
+    return mVal == 0xF7 ? Status::SysEx : Status::Error;
   }
 
 private:
@@ -123,23 +173,23 @@ private:
 
 // Parse Frequent Tasks
 template <std::size_t len>
-constexpr auto CheckLength = [](const std::uint8_t *, std::size_t length) -> ParseInfo {
+constexpr auto CheckLength = [](const std::uint8_t *, std::size_t length, MidiEvent *) -> ParseInfo {
   return length < len ? ParseInfo{ParseInfo::E::ERROR_MSG_TOO_SHORT} : ParseInfo{};
 };
 
 template <std::size_t len>
-constexpr auto HasLength = [](const std::uint8_t *, std::size_t length) -> bool {
+constexpr auto HasLength = [](const std::uint8_t *, std::size_t length, MidiEvent *) -> bool {
   return length == len;
 };
 
 template <std::size_t len>
-constexpr auto StripBytes = [](const std::uint8_t *&bytes, std::size_t &length) -> ParseInfo {
+constexpr auto StripBytes = [](const std::uint8_t *&bytes, std::size_t &length, MidiEvent *) -> ParseInfo {
   bytes = length > len ? bytes + len : bytes + length;
   length = length > len ? length - len : 0;
   return {};
 };
 
-constexpr auto StripStatus = [](const std::uint8_t *&bytes, std::size_t &length) -> ParseInfo {
+constexpr auto StripStatus = [](const std::uint8_t *&bytes, std::size_t &length, MidiEvent *) -> ParseInfo {
   if (length < 2)
     return {ParseInfo::E::ERROR_MSG_TOO_SHORT};
   ++bytes, length -= 2;
@@ -152,7 +202,7 @@ constexpr auto Unimplemented = [](auto ...) { return ParseInfo{ParseInfo::E::UNI
 
 // Parse Conditions
 template <std::size_t idx, std::uint8_t mask>
-constexpr auto GetByteMask = [](const std::uint8_t *bytes, std::size_t) -> std::uint8_t {
+constexpr auto GetByteMask = [](const std::uint8_t *bytes, std::size_t, MidiEvent *) -> std::uint8_t {
   return bytes[idx] & mask;
 };
 
@@ -186,49 +236,49 @@ struct MidiBytes : NotInstantiable
     struct NoteOff : NotInstantiable
     {
       static constexpr std::uint8_t value = 0x80;
-      static constexpr ParseInfo method(const std::uint8_t *, std::size_t);
+      static constexpr ParseInfo method(const std::uint8_t *, std::size_t, MidiEvent *);
       static constexpr auto insight = [](auto...) { return MidiSize::Match<3>(); };
     };
 
     struct NoteOn : NotInstantiable
     {
       static constexpr std::uint8_t value = 0x90;
-      static constexpr ParseInfo method(const std::uint8_t *, std::size_t);
+      static constexpr ParseInfo method(const std::uint8_t *, std::size_t, MidiEvent *);
       static constexpr auto insight = [](auto...) { return MidiSize::Match<3>(); };
     };
 
     struct PolyPressure : NotInstantiable
     {
       static constexpr std::uint8_t value = 0xA0;
-      static constexpr ParseInfo method(const std::uint8_t *, std::size_t);
+      static constexpr ParseInfo method(const std::uint8_t *, std::size_t, MidiEvent *);
       static constexpr auto insight = [](auto...) { return MidiSize::Match<3>(); };
     };
 
     struct ControlChange : NotInstantiable
     {
       static constexpr std::uint8_t value = 0xB0;
-      static constexpr ParseInfo method(const std::uint8_t *, std::size_t);
+      static constexpr ParseInfo method(const std::uint8_t *, std::size_t, MidiEvent *);
       static constexpr auto insight = [](auto...) { return MidiSize::Match<3>(); };
     };
 
     struct ProgramChange : NotInstantiable
     {
       static constexpr std::uint8_t value = 0xC0;
-      static constexpr ParseInfo method(const std::uint8_t *, std::size_t);
+      static constexpr ParseInfo method(const std::uint8_t *, std::size_t, MidiEvent *);
       static constexpr auto insight = [](auto...) { return MidiSize::Match<2>(); };
     };
 
     struct ChannelPressure : NotInstantiable
     {
       static constexpr std::uint8_t value = 0xD0;
-      static constexpr ParseInfo method(const std::uint8_t *, std::size_t);
+      static constexpr ParseInfo method(const std::uint8_t *, std::size_t, MidiEvent *);
       static constexpr auto insight = [](auto...) { return MidiSize::Match<2>(); };
     };
 
     struct PitchBend : NotInstantiable
     {
       static constexpr std::uint8_t value = 0xE0;
-      static constexpr ParseInfo method(const std::uint8_t *, std::size_t);
+      static constexpr ParseInfo method(const std::uint8_t *, std::size_t, MidiEvent *);
       static constexpr auto insight = [](auto...) { return MidiSize::Match<3>(); };
     };
 
@@ -242,72 +292,72 @@ struct MidiBytes : NotInstantiable
           struct SampleDumpHeader : NotInstantiable
           {
             static constexpr std::uint8_t value = 0x01;
-            static constexpr ParseInfo method(const std::uint8_t *, std::size_t);
+            static constexpr ParseInfo method(const std::uint8_t *, std::size_t, MidiEvent *);
           };
           struct SampleDataPacket : NotInstantiable
           {
             static constexpr std::uint8_t value = 0x02;
-            static constexpr ParseInfo method(const std::uint8_t *, std::size_t);
+            static constexpr ParseInfo method(const std::uint8_t *, std::size_t, MidiEvent *);
           };
           struct SampleDumpRequest : NotInstantiable
           {
             static constexpr std::uint8_t value = 0x03;
-            static constexpr ParseInfo method(const std::uint8_t *, std::size_t);
+            static constexpr ParseInfo method(const std::uint8_t *, std::size_t, MidiEvent *);
           };
           struct MidiTimeCode : NotInstantiable
           {
             static constexpr std::uint8_t value = 0x04;
-            static constexpr ParseInfo method(const std::uint8_t *, std::size_t);
+            static constexpr ParseInfo method(const std::uint8_t *, std::size_t, MidiEvent *);
           };
           struct SampleDumpExtensions : NotInstantiable
           {
             static constexpr std::uint8_t value = 0x05;
-            static constexpr ParseInfo method(const std::uint8_t *, std::size_t);
+            static constexpr ParseInfo method(const std::uint8_t *, std::size_t, MidiEvent *);
           };
           struct GeneralInformation : NotInstantiable
           {
             static constexpr std::uint8_t value = 0x06;
-            static constexpr ParseInfo method(const std::uint8_t *, std::size_t);
+            static constexpr ParseInfo method(const std::uint8_t *, std::size_t, MidiEvent *);
           };
           struct FileDump : NotInstantiable
           {
             static constexpr std::uint8_t value = 0x07;
-            static constexpr ParseInfo method(const std::uint8_t *, std::size_t);
+            static constexpr ParseInfo method(const std::uint8_t *, std::size_t, MidiEvent *);
           };
           struct MidiTuningStandard : NotInstantiable
           {
             static constexpr std::uint8_t value = 0x08;
-            static constexpr ParseInfo method(const std::uint8_t *, std::size_t);
+            static constexpr ParseInfo method(const std::uint8_t *, std::size_t, MidiEvent *);
           };
           struct GeneralMidi : NotInstantiable
           {
             static constexpr std::uint8_t value = 0x09;
-            static constexpr ParseInfo method(const std::uint8_t *, std::size_t);
+            static constexpr ParseInfo method(const std::uint8_t *, std::size_t, MidiEvent *);
           };
           struct EndOfFile : NotInstantiable
           {
             static constexpr std::uint8_t value = 0x7B;
-            static constexpr ParseInfo method(const std::uint8_t *, std::size_t);
+            static constexpr ParseInfo method(const std::uint8_t *, std::size_t, MidiEvent *);
           };
           struct Wait : NotInstantiable
           {
             static constexpr std::uint8_t value = 0x7C;
-            static constexpr ParseInfo method(const std::uint8_t *, std::size_t);
+            static constexpr ParseInfo method(const std::uint8_t *, std::size_t, MidiEvent *);
           };
           struct Cancel : NotInstantiable
           {
             static constexpr std::uint8_t value = 0x7D;
-            static constexpr ParseInfo method(const std::uint8_t *, std::size_t);
+            static constexpr ParseInfo method(const std::uint8_t *, std::size_t, MidiEvent *);
           };
           struct NAK : NotInstantiable
           {
             static constexpr std::uint8_t value = 0x7E;
-            static constexpr ParseInfo method(const std::uint8_t *, std::size_t);
+            static constexpr ParseInfo method(const std::uint8_t *, std::size_t, MidiEvent *);
           };
           struct ACK : NotInstantiable
           {
             static constexpr std::uint8_t value = 0x7F;
-            static constexpr ParseInfo method(const std::uint8_t *, std::size_t);
+            static constexpr ParseInfo method(const std::uint8_t *, std::size_t, MidiEvent *);
           };
 
         private:
@@ -329,10 +379,10 @@ struct MidiBytes : NotInstantiable
 
         public:
           static constexpr std::uint8_t value = 0x7E;
-          static constexpr auto method = pgm::Process<ParseInfo(const std::uint8_t *&, std::size_t &)>{}
+          static constexpr auto method = pgm::Process<ParseInfo(const std::uint8_t *&, std::size_t &, MidiEvent *)>{}
             << StripBytes<1>
             << CheckLength<2>
-            << SwitcherFactory::Parse<ParseInfo(const std::uint8_t *, std::size_t), CaseList>(
+            << SwitcherFactory::Parse<ParseInfo(const std::uint8_t *, std::size_t, MidiEvent *), CaseList>(
               GetByteMask<1, 0xFF>,
               InvalidParse);
         };
@@ -342,42 +392,42 @@ struct MidiBytes : NotInstantiable
           struct MidiTimeCode : NotInstantiable
           {
             static constexpr std::uint8_t value = 0x01;
-            static constexpr ParseInfo method(const std::uint8_t *, std::size_t);
+            static constexpr ParseInfo method(const std::uint8_t *, std::size_t, MidiEvent *);
           };
           struct ShowControls : NotInstantiable
           {
             static constexpr std::uint8_t value = 0x02;
-            static constexpr ParseInfo method(const std::uint8_t *, std::size_t);
+            static constexpr ParseInfo method(const std::uint8_t *, std::size_t, MidiEvent *);
           };
           struct NotationInfo : NotInstantiable
           {
             static constexpr std::uint8_t value = 0x03;
-            static constexpr ParseInfo method(const std::uint8_t *, std::size_t);
+            static constexpr ParseInfo method(const std::uint8_t *, std::size_t, MidiEvent *);
           };
           struct DeviceControl : NotInstantiable
           {
             static constexpr std::uint8_t value = 0x04;
-            static constexpr ParseInfo method(const std::uint8_t *, std::size_t);
+            static constexpr ParseInfo method(const std::uint8_t *, std::size_t, MidiEvent *);
           };
           struct RTMTCCue : NotInstantiable
           {
             static constexpr std::uint8_t value = 0x05;
-            static constexpr ParseInfo method(const std::uint8_t *, std::size_t);
+            static constexpr ParseInfo method(const std::uint8_t *, std::size_t, MidiEvent *);
           };
           struct MMCCommands : NotInstantiable
           {
             static constexpr std::uint8_t value = 0x06;
-            static constexpr ParseInfo method(const std::uint8_t *, std::size_t);
+            static constexpr ParseInfo method(const std::uint8_t *, std::size_t, MidiEvent *);
           };
           struct MMCResponse : NotInstantiable
           {
             static constexpr std::uint8_t value = 0x07;
-            static constexpr ParseInfo method(const std::uint8_t *, std::size_t);
+            static constexpr ParseInfo method(const std::uint8_t *, std::size_t, MidiEvent *);
           };
           struct MidiTuning : NotInstantiable
           {
             static constexpr std::uint8_t value = 0x08;
-            static constexpr ParseInfo method(const std::uint8_t *, std::size_t);
+            static constexpr ParseInfo method(const std::uint8_t *, std::size_t, MidiEvent *);
           };
 
         private:
@@ -393,10 +443,10 @@ struct MidiBytes : NotInstantiable
 
         public:
           static constexpr std::uint8_t value = 0x7F;
-          static constexpr auto method = pgm::Process<ParseInfo(const std::uint8_t *&, std::size_t &)>{}
+          static constexpr auto method = pgm::Process<ParseInfo(const std::uint8_t *&, std::size_t &, MidiEvent *)>{}
             << StripBytes<1>
             << CheckLength<2>
-            << SwitcherFactory::Parse<ParseInfo(const std::uint8_t *, std::size_t), CaseList>(
+            << SwitcherFactory::Parse<ParseInfo(const std::uint8_t *, std::size_t, MidiEvent *), CaseList>(
               GetByteMask<1, 0xFF>,
               InvalidParse);
         };
@@ -408,79 +458,79 @@ struct MidiBytes : NotInstantiable
 
       public:
         // @return false if there is a match else true
-        static constexpr ParseInfo specificMatchFunction(const std::uint8_t *&, std::size_t &);
-        static constexpr ParseInfo interpretSpecificSysEx(const std::uint8_t *, std::size_t);
+        static constexpr ParseInfo specificMatchFunction(const std::uint8_t *&, std::size_t &, MidiEvent *);
+        static constexpr ParseInfo interpretSpecificSysEx(const std::uint8_t *, std::size_t, MidiEvent *);
 
         static constexpr std::uint8_t value = 0xF0;
         static constexpr auto method =
-          pgm::Process<ParseInfo(const std::uint8_t *&, std::size_t &)>{}
+          pgm::Process<ParseInfo(const std::uint8_t *&, std::size_t &, MidiEvent *)>{}
           << StripStatus
           << CheckLength<1>
-          << SwitcherFactory::Parse<ParseInfo(const std::uint8_t *, std::size_t), CaseList>(
+          << SwitcherFactory::Parse<ParseInfo(const std::uint8_t *, std::size_t, MidiEvent *), CaseList>(
             GetFirstByte,
-            pgm::Process<ParseInfo(const std::uint8_t *&, std::size_t &)>{} << specificMatchFunction << interpretSpecificSysEx);
+            pgm::Process<ParseInfo(const std::uint8_t *&, std::size_t &, MidiEvent *)>{} << specificMatchFunction << interpretSpecificSysEx);
 
         static constexpr auto insight = [](auto...) { return MidiSize::Syx(); };
       };
       struct MTC : NotInstantiable
       {
         static constexpr std::uint8_t value = 0xF1;
-        static constexpr ParseInfo method(const std::uint8_t *, std::size_t);
+        static constexpr ParseInfo method(const std::uint8_t *, std::size_t, MidiEvent *);
         static constexpr auto insight = [](auto...) { return MidiSize::Match<2>(); };
       };
       struct Songpos : NotInstantiable
       {
         static constexpr std::uint8_t value = 0xF2;
-        static constexpr ParseInfo method(const std::uint8_t *, std::size_t);
+        static constexpr ParseInfo method(const std::uint8_t *, std::size_t, MidiEvent *);
         static constexpr auto insight = [](auto...) { return MidiSize::Match<3>(); };
       };
       struct SongSel : NotInstantiable
       {
         static constexpr std::uint8_t value = 0xF3;
-        static constexpr ParseInfo method(const std::uint8_t *, std::size_t);
+        static constexpr ParseInfo method(const std::uint8_t *, std::size_t, MidiEvent *);
         static constexpr auto insight = [](auto...) { return MidiSize::Match<2>(); };
       };
       struct TuneRequest : NotInstantiable
       {
         static constexpr std::uint8_t value = 0xF6;
-        static constexpr ParseInfo method(const std::uint8_t *, std::size_t);
+        static constexpr ParseInfo method(const std::uint8_t *, std::size_t, MidiEvent *);
         static constexpr auto insight = [](auto...) { return MidiSize::Match<1>(); };
       };
       // System Real Time
       struct TimingClock : NotInstantiable
       {
         static constexpr std::uint8_t value = 0xF8;
-        static constexpr ParseInfo method(const std::uint8_t *, std::size_t);
+        static constexpr ParseInfo method(const std::uint8_t *, std::size_t, MidiEvent *);
         static constexpr auto insight = [](auto...) { return MidiSize::Match<1>(); };
       };
       struct Start : NotInstantiable
       {
         static constexpr std::uint8_t value = 0xFA;
-        static constexpr ParseInfo method(const std::uint8_t *, std::size_t);
+        static constexpr ParseInfo method(const std::uint8_t *, std::size_t, MidiEvent *);
         static constexpr auto insight = [](auto...) { return MidiSize::Match<1>(); };
       };
       struct Continue : NotInstantiable
       {
         static constexpr std::uint8_t value = 0xFB;
-        static constexpr ParseInfo method(const std::uint8_t *, std::size_t);
+        static constexpr ParseInfo method(const std::uint8_t *, std::size_t, MidiEvent *);
         static constexpr auto insight = [](auto...) { return MidiSize::Match<1>(); };
       };
       struct Stop : NotInstantiable
       {
         static constexpr std::uint8_t value = 0xFC;
-        static constexpr ParseInfo method(const std::uint8_t *, std::size_t);
+        static constexpr ParseInfo method(const std::uint8_t *, std::size_t, MidiEvent *);
         static constexpr auto insight = [](auto...) { return MidiSize::Match<1>(); };
       };
       struct ActiveSensing : NotInstantiable
       {
         static constexpr std::uint8_t value = 0xFE;
-        static constexpr ParseInfo method(const std::uint8_t *, std::size_t);
+        static constexpr ParseInfo method(const std::uint8_t *, std::size_t, MidiEvent *);
         static constexpr auto insight = [](auto...) { return MidiSize::Match<1>(); };
       };
       struct SystemReset : NotInstantiable
       {
         static constexpr std::uint8_t value = 0xFF;
-        static constexpr ParseInfo method(const std::uint8_t *, std::size_t);
+        static constexpr ParseInfo method(const std::uint8_t *, std::size_t, MidiEvent *);
         static constexpr auto insight = [](auto...) { return MidiSize::Match<1>(); };
       };
 
@@ -500,14 +550,16 @@ struct MidiBytes : NotInstantiable
 
     public:
       static constexpr std::uint8_t value = 0xF0;
-      static constexpr auto method = pgm::Process<ParseInfo(const std::uint8_t *&, std::size_t &)>{}
-        << SwitcherFactory::Parse<ParseInfo(const std::uint8_t *, std::size_t), CaseList>(
+      static constexpr auto method = pgm::Process<ParseInfo(const std::uint8_t *&, std::size_t &, MidiEvent *)>{}
+        << SwitcherFactory::Parse<ParseInfo(const std::uint8_t *, std::size_t, MidiEvent *), CaseList>(
           GetFirstByte,
           InvalidParse);
 
       static constexpr auto insight = SwitcherFactory::Size<MidiSize(std::uint8_t), CaseList>(
         u8Forward,
         InvalidInsight);
+
+      static constexpr auto methodTable = SwitcherFactory::Table<ParseInfo(const std::uint8_t *, std::size_t, MidiEvent *), CaseList, 0xFF>(InvalidParse);
     };
 
   private:
@@ -523,13 +575,21 @@ struct MidiBytes : NotInstantiable
 
   public:
     static constexpr std::uint8_t value = 0x80;
-    static constexpr auto method = SwitcherFactory::Parse<ParseInfo(const std::uint8_t *, std::size_t), CaseList>(
+    static constexpr auto method = SwitcherFactory::Parse<ParseInfo(const std::uint8_t *, std::size_t, MidiEvent *), CaseList>(
       GetFirstByteMask<0xF0>,
       InvalidParse);
 
     static constexpr auto insight = SwitcherFactory::Size<MidiSize(std::uint8_t), CaseList>(
       u8Mask<0xF0>,
       InvalidInsight);
+
+    // Flattened first byte tables, system messages resolved down to their leaf
+    static constexpr auto insightTable = SwitcherFactory::SizeTable(insight);
+    static constexpr auto methodTable = SwitcherFactory::Overlay(
+      SwitcherFactory::Table<ParseInfo(const std::uint8_t *, std::size_t, MidiEvent *), CaseList, 0xF0>(InvalidParse),
+      SystemMessage::methodTable,
+      SystemMessage::value,
+      0xF0);
   };
 
   struct M2 : NotInstantiable
@@ -540,28 +600,40 @@ struct MidiBytes : NotInstantiable
       struct NOOP : NotInstantiable
       {
         static constexpr std::uint8_t value = 0x00;
-        static constexpr ParseInfo method(const std::uint8_t *, std::size_t);
+        static constexpr ParseInfo method(const std::uint8_t *, std::size_t, MidiEvent *);
       };
       struct JRClock : NotInstantiable
       {
         static constexpr std::uint8_t value = 0x10;
-        static constexpr ParseInfo method(const std::uint8_t *, std::size_t);
+        static constexpr ParseInfo method(const std::uint8_t *, std::size_t, MidiEvent *);
       };
       struct JRTimestamp : NotInstantiable
       {
         static constexpr std::uint8_t value = 0x20;
-        static constexpr ParseInfo method(const std::uint8_t *, std::size_t);
+        static constexpr ParseInfo method(const std::uint8_t *, std::size_t, MidiEvent *);
+      };
+      struct DeltaClockstampTPQ : NotInstantiable
+      {
+        static constexpr std::uint8_t value = 0x30;
+        static constexpr ParseInfo method(const std::uint8_t *, std::size_t, MidiEvent *);
+      };
+      struct DeltaClockstamp : NotInstantiable
+      {
+        static constexpr std::uint8_t value = 0x40;
+        static constexpr ParseInfo method(const std::uint8_t *, std::size_t, MidiEvent *);
       };
 
     private:
       using CaseList = std::tuple<
         NOOP,
         JRClock,
-        JRTimestamp>;
+        JRTimestamp,
+        DeltaClockstampTPQ,
+        DeltaClockstamp>;
 
     public:
       static constexpr std::uint8_t value = 0x00;
-      static constexpr auto method = SwitcherFactory::Parse<ParseInfo(const std::uint8_t *, std::size_t), CaseList>(
+      static constexpr auto method = SwitcherFactory::Parse<ParseInfo(const std::uint8_t *, std::size_t, MidiEvent *), CaseList>(
         GetByteMask<1, 0xF0>,
         InvalidParse);
 
@@ -572,52 +644,52 @@ struct MidiBytes : NotInstantiable
       struct MTC : NotInstantiable
       {
         static constexpr std::uint8_t value = 0xF1;
-        static constexpr ParseInfo method(const std::uint8_t *, std::size_t);
+        static constexpr ParseInfo method(const std::uint8_t *, std::size_t, MidiEvent *);
       };
       struct SongPos : NotInstantiable
       {
         static constexpr std::uint8_t value = 0xF2;
-        static constexpr ParseInfo method(const std::uint8_t *, std::size_t);
+        static constexpr ParseInfo method(const std::uint8_t *, std::size_t, MidiEvent *);
       };
       struct SongSel : NotInstantiable
       {
         static constexpr std::uint8_t value = 0xF3;
-        static constexpr ParseInfo method(const std::uint8_t *, std::size_t);
+        static constexpr ParseInfo method(const std::uint8_t *, std::size_t, MidiEvent *);
       };
       struct TuneRequest : NotInstantiable
       {
         static constexpr std::uint8_t value = 0xF6;
-        static constexpr ParseInfo method(const std::uint8_t *, std::size_t);
+        static constexpr ParseInfo method(const std::uint8_t *, std::size_t, MidiEvent *);
       };
       struct TimingClock : NotInstantiable
       {
         static constexpr std::uint8_t value = 0xF8;
-        static constexpr ParseInfo method(const std::uint8_t *, std::size_t);
+        static constexpr ParseInfo method(const std::uint8_t *, std::size_t, MidiEvent *);
       };
       struct Start : NotInstantiable
       {
         static constexpr std::uint8_t value = 0xFA;
-        static constexpr ParseInfo method(const std::uint8_t *, std::size_t);
+        static constexpr ParseInfo method(const std::uint8_t *, std::size_t, MidiEvent *);
       };
       struct Continue : NotInstantiable
       {
         static constexpr std::uint8_t value = 0xFB;
-        static constexpr ParseInfo method(const std::uint8_t *, std::size_t);
+        static constexpr ParseInfo method(const std::uint8_t *, std::size_t, MidiEvent *);
       };
       struct Stop : NotInstantiable
       {
         static constexpr std::uint8_t value = 0xFC;
-        static constexpr ParseInfo method(const std::uint8_t *, std::size_t);
+        static constexpr ParseInfo method(const std::uint8_t *, std::size_t, MidiEvent *);
       };
       struct ActiveSensing : NotInstantiable
       {
         static constexpr std::uint8_t value = 0xFE;
-        static constexpr ParseInfo method(const std::uint8_t *, std::size_t);
+        static constexpr ParseInfo method(const std::uint8_t *, std::size_t, MidiEvent *);
       };
       struct Reset : NotInstantiable
       {
         static constexpr std::uint8_t value = 0xFF;
-        static constexpr ParseInfo method(const std::uint8_t *, std::size_t);
+        static constexpr ParseInfo method(const std::uint8_t *, std::size_t, MidiEvent *);
       };
 
     private:
@@ -635,7 +707,7 @@ struct MidiBytes : NotInstantiable
 
     public:
       static constexpr std::uint8_t value = 0x10;
-      static constexpr auto method = SwitcherFactory::Parse<ParseInfo(const std::uint8_t *, std::size_t), CaseList>(
+      static constexpr auto method = SwitcherFactory::Parse<ParseInfo(const std::uint8_t *, std::size_t, MidiEvent *), CaseList>(
         GetByteMask<1, 0xFF>,
         InvalidParse);
 
@@ -646,37 +718,37 @@ struct MidiBytes : NotInstantiable
       struct NoteOff : NotInstantiable
       {
         static constexpr std::uint8_t value = 0x80;
-        static constexpr ParseInfo method(const std::uint8_t *, std::size_t);
+        static constexpr ParseInfo method(const std::uint8_t *, std::size_t, MidiEvent *);
       };
       struct NoteOn : NotInstantiable
       {
         static constexpr std::uint8_t value = 0x90;
-        static constexpr ParseInfo method(const std::uint8_t *, std::size_t);
+        static constexpr ParseInfo method(const std::uint8_t *, std::size_t, MidiEvent *);
       };
       struct PolyPressure : NotInstantiable
       {
         static constexpr std::uint8_t value = 0xA0;
-        static constexpr ParseInfo method(const std::uint8_t *, std::size_t);
+        static constexpr ParseInfo method(const std::uint8_t *, std::size_t, MidiEvent *);
       };
       struct ControlChange : NotInstantiable
       {
         static constexpr std::uint8_t value = 0xB0;
-        static constexpr ParseInfo method(const std::uint8_t *, std::size_t);
+        static constexpr ParseInfo method(const std::uint8_t *, std::size_t, MidiEvent *);
       };
       struct ProgramChange : NotInstantiable
       {
         static constexpr std::uint8_t value = 0xC0;
-        static constexpr ParseInfo method(const std::uint8_t *, std::size_t);
+        static constexpr ParseInfo method(const std::uint8_t *, std::size_t, MidiEvent *);
       };
       struct ChannelPressure : NotInstantiable
       {
         static constexpr std::uint8_t value = 0xD0;
-        static constexpr ParseInfo method(const std::uint8_t *, std::size_t);
+        static constexpr ParseInfo method(const std::uint8_t *, std::size_t, MidiEvent *);
       };
       struct PitchBend : NotInstantiable
       {
         static constexpr std::uint8_t value = 0xE0;
-        static constexpr ParseInfo method(const std::uint8_t *, std::size_t);
+        static constexpr ParseInfo method(const std::uint8_t *, std::size_t, MidiEvent *);
       };
 
     private:
@@ -691,7 +763,7 @@ struct MidiBytes : NotInstantiable
 
     public:
       static constexpr std::uint8_t value = 0x20;
-      static constexpr auto method = SwitcherFactory::Parse<ParseInfo(const std::uint8_t *, std::size_t), CaseList>(
+      static constexpr auto method = SwitcherFactory::Parse<ParseInfo(const std::uint8_t *, std::size_t, MidiEvent *), CaseList>(
         GetByteMask<1, 0xF0>,
         InvalidParse);
 
@@ -702,22 +774,22 @@ struct MidiBytes : NotInstantiable
       struct SysEx1Packet : NotInstantiable
       {
         static constexpr std::uint8_t value = 0x00;
-        static constexpr ParseInfo method(const std::uint8_t *, std::size_t);
+        static constexpr ParseInfo method(const std::uint8_t *, std::size_t, MidiEvent *);
       };
       struct SysExStart : NotInstantiable
       {
         static constexpr std::uint8_t value = 0x10;
-        static constexpr ParseInfo method(const std::uint8_t *, std::size_t);
+        static constexpr ParseInfo method(const std::uint8_t *, std::size_t, MidiEvent *);
       };
       struct SysExContinue : NotInstantiable
       {
         static constexpr std::uint8_t value = 0x20;
-        static constexpr ParseInfo method(const std::uint8_t *, std::size_t);
+        static constexpr ParseInfo method(const std::uint8_t *, std::size_t, MidiEvent *);
       };
       struct SysExEnd : NotInstantiable
       {
         static constexpr std::uint8_t value = 0x30;
-        static constexpr ParseInfo method(const std::uint8_t *, std::size_t);
+        static constexpr ParseInfo method(const std::uint8_t *, std::size_t, MidiEvent *);
       };
 
     private:
@@ -729,9 +801,9 @@ struct MidiBytes : NotInstantiable
 
     public:
       static constexpr std::uint8_t value = 0x30;
-      static constexpr auto method = pgm::Process<ParseInfo(const std::uint8_t *, std::size_t)>{}
+      static constexpr auto method = pgm::Process<ParseInfo(const std::uint8_t *, std::size_t, MidiEvent *)>{}
         << CheckLength<8>
-        << SwitcherFactory::Parse<ParseInfo(const std::uint8_t *, std::size_t), CaseList>(
+        << SwitcherFactory::Parse<ParseInfo(const std::uint8_t *, std::size_t, MidiEvent *), CaseList>(
           GetByteMask<1, 0xF0>,
           InvalidParse);
 
@@ -742,77 +814,77 @@ struct MidiBytes : NotInstantiable
       struct RegistPerNoteCtrl : NotInstantiable
       {
         static constexpr std::uint8_t value = 0x00;
-        static constexpr ParseInfo method(const std::uint8_t *, std::size_t);
+        static constexpr ParseInfo method(const std::uint8_t *, std::size_t, MidiEvent *);
       };
       struct AssignPerNoteCtrl : NotInstantiable
       {
         static constexpr std::uint8_t value = 0x10;
-        static constexpr ParseInfo method(const std::uint8_t *, std::size_t);
+        static constexpr ParseInfo method(const std::uint8_t *, std::size_t, MidiEvent *);
       };
       struct RegistCtrl : NotInstantiable
       {
         static constexpr std::uint8_t value = 0x20;
-        static constexpr ParseInfo method(const std::uint8_t *, std::size_t);
+        static constexpr ParseInfo method(const std::uint8_t *, std::size_t, MidiEvent *);
       };
       struct AssignCtrl : NotInstantiable
       {
         static constexpr std::uint8_t value = 0x30;
-        static constexpr ParseInfo method(const std::uint8_t *, std::size_t);
+        static constexpr ParseInfo method(const std::uint8_t *, std::size_t, MidiEvent *);
       };
       struct RelativeRegistCtrl : NotInstantiable
       {
         static constexpr std::uint8_t value = 0x40;
-        static constexpr ParseInfo method(const std::uint8_t *, std::size_t);
+        static constexpr ParseInfo method(const std::uint8_t *, std::size_t, MidiEvent *);
       };
       struct RelativeAssignCtrl : NotInstantiable
       {
-        static constexpr std::uint8_t value = 0x60;
-        static constexpr ParseInfo method(const std::uint8_t *, std::size_t);
+        static constexpr std::uint8_t value = 0x50;
+        static constexpr ParseInfo method(const std::uint8_t *, std::size_t, MidiEvent *);
       };
       struct PerNotePitchBend : NotInstantiable
       {
-        static constexpr std::uint8_t value = 0x70;
-        static constexpr ParseInfo method(const std::uint8_t *, std::size_t);
+        static constexpr std::uint8_t value = 0x60;
+        static constexpr ParseInfo method(const std::uint8_t *, std::size_t, MidiEvent *);
       };
       struct NoteOff : NotInstantiable
       {
         static constexpr std::uint8_t value = 0x80;
-        static constexpr ParseInfo method(const std::uint8_t *, std::size_t);
+        static constexpr ParseInfo method(const std::uint8_t *, std::size_t, MidiEvent *);
       };
       struct NoteOn : NotInstantiable
       {
         static constexpr std::uint8_t value = 0x90;
-        static constexpr ParseInfo method(const std::uint8_t *, std::size_t);
+        static constexpr ParseInfo method(const std::uint8_t *, std::size_t, MidiEvent *);
       };
       struct PolyPressure : NotInstantiable
       {
         static constexpr std::uint8_t value = 0xA0;
-        static constexpr ParseInfo method(const std::uint8_t *, std::size_t);
+        static constexpr ParseInfo method(const std::uint8_t *, std::size_t, MidiEvent *);
       };
       struct ControlChange : NotInstantiable
       {
         static constexpr std::uint8_t value = 0xB0;
-        static constexpr ParseInfo method(const std::uint8_t *, std::size_t);
+        static constexpr ParseInfo method(const std::uint8_t *, std::size_t, MidiEvent *);
       };
       struct ProgramChange : NotInstantiable
       {
         static constexpr std::uint8_t value = 0xC0;
-        static constexpr ParseInfo method(const std::uint8_t *, std::size_t);
+        static constexpr ParseInfo method(const std::uint8_t *, std::size_t, MidiEvent *);
       };
       struct ChannelPressure : NotInstantiable
       {
         static constexpr std::uint8_t value = 0xD0;
-        static constexpr ParseInfo method(const std::uint8_t *, std::size_t);
+        static constexpr ParseInfo method(const std::uint8_t *, std::size_t, MidiEvent *);
       };
       struct PitchBend : NotInstantiable
       {
         static constexpr std::uint8_t value = 0xE0;
-        static constexpr ParseInfo method(const std::uint8_t *, std::size_t);
+        static constexpr ParseInfo method(const std::uint8_t *, std::size_t, MidiEvent *);
       };
       struct PerNoteManagement : NotInstantiable
       {
         static constexpr std::uint8_t value = 0xF0;
-        static constexpr ParseInfo method(const std::uint8_t *, std::size_t);
+        static constexpr ParseInfo method(const std::uint8_t *, std::size_t, MidiEvent *);
       };
     private:
       using CaseList = std::tuple<
@@ -834,9 +906,9 @@ struct MidiBytes : NotInstantiable
 
     public:
       static constexpr std::uint8_t value = 0x40;
-      static constexpr auto method = pgm::Process<ParseInfo(const std::uint8_t *, std::size_t)>{}
+      static constexpr auto method = pgm::Process<ParseInfo(const std::uint8_t *, std::size_t, MidiEvent *)>{}
         << CheckLength<8>
-        << SwitcherFactory::Parse<ParseInfo(const std::uint8_t *, std::size_t), CaseList>(
+        << SwitcherFactory::Parse<ParseInfo(const std::uint8_t *, std::size_t, MidiEvent *), CaseList>(
           GetByteMask<1, 0xF0>,
           InvalidParse);
 
@@ -847,32 +919,32 @@ struct MidiBytes : NotInstantiable
       struct SysEx8In1Packet : NotInstantiable
       {
         static constexpr std::uint8_t value = 0x00;
-        static constexpr ParseInfo method(const std::uint8_t *, std::size_t);
+        static constexpr ParseInfo method(const std::uint8_t *, std::size_t, MidiEvent *);
       };
       struct SysEx8Start : NotInstantiable
       {
         static constexpr std::uint8_t value = 0x10;
-        static constexpr ParseInfo method(const std::uint8_t *, std::size_t);
+        static constexpr ParseInfo method(const std::uint8_t *, std::size_t, MidiEvent *);
       };
       struct SysEx8Continue : NotInstantiable
       {
         static constexpr std::uint8_t value = 0x20;
-        static constexpr ParseInfo method(const std::uint8_t *, std::size_t);
+        static constexpr ParseInfo method(const std::uint8_t *, std::size_t, MidiEvent *);
       };
       struct SysEx8End : NotInstantiable
       {
         static constexpr std::uint8_t value = 0x30;
-        static constexpr ParseInfo method(const std::uint8_t *, std::size_t);
+        static constexpr ParseInfo method(const std::uint8_t *, std::size_t, MidiEvent *);
       };
       struct MixedDataSetHeader : NotInstantiable
       {
         static constexpr std::uint8_t value = 0x80;
-        static constexpr ParseInfo method(const std::uint8_t *, std::size_t);
+        static constexpr ParseInfo method(const std::uint8_t *, std::size_t, MidiEvent *);
       };
       struct MixedDataSetPayload : NotInstantiable
       {
         static constexpr std::uint8_t value = 0x90;
-        static constexpr ParseInfo method(const std::uint8_t *, std::size_t);
+        static constexpr ParseInfo method(const std::uint8_t *, std::size_t, MidiEvent *);
       };
 
     private:
@@ -886,9 +958,9 @@ struct MidiBytes : NotInstantiable
 
     public:
       static constexpr std::uint8_t value = 0x50;
-      static constexpr auto method = pgm::Process<ParseInfo(const std::uint8_t *, std::size_t)>{}
+      static constexpr auto method = pgm::Process<ParseInfo(const std::uint8_t *, std::size_t, MidiEvent *)>{}
         << CheckLength<16>
-        << SwitcherFactory::Parse<ParseInfo(const std::uint8_t *, std::size_t), CaseList>(
+        << SwitcherFactory::Parse<ParseInfo(const std::uint8_t *, std::size_t, MidiEvent *), CaseList>(
           GetByteMask<1, 0xF0>,
           InvalidParse);
 
@@ -911,37 +983,66 @@ struct MidiBytes : NotInstantiable
     static constexpr auto allowMidi2Parse = [](auto...) { return isMidi2Enabled() ? ParseInfo{} : ParseInfo{ParseInfo::E::UNIMPLEMENTED}; };
     static constexpr auto allowMidi2Insight = [](auto...) { return isMidi2Enabled() ? MidiSize{} : MidiSize::Discard<1>(); };
 
+    static constexpr auto insightCases = SwitcherFactory::Size<MidiSize(std::uint8_t), CaseList>(
+      u8Mask<0xF0>,
+      InvalidInsight);
+
+    // Message type case applying the MIDI 2.0 enable & minimal length checks of M2::method
+    template <typename Case_t>
+    struct Checked : NotInstantiable
+    {
+      static constexpr std::uint8_t value = Case_t::value;
+      static constexpr auto method = pgm::Process<ParseInfo(const std::uint8_t *&, std::size_t &, MidiEvent *)>{}
+        << allowMidi2Parse
+        << CheckLength<4>
+        << Case_t::method;
+    };
+
+    template <typename CaseTuple_t>
+    struct CheckedList;
+    template <typename... Case_t>
+    struct CheckedList<std::tuple<Case_t...>>
+    {
+      using type = std::tuple<Checked<Case_t>...>;
+    };
+
   public:
     static constexpr std::uint8_t value = 0x00;
-    static constexpr auto method = pgm::Process<ParseInfo(const std::uint8_t *&, std::size_t &)>{}
+    static constexpr auto method = pgm::Process<ParseInfo(const std::uint8_t *&, std::size_t &, MidiEvent *)>{}
       << allowMidi2Parse
       << CheckLength<4>
-      << SwitcherFactory::Parse<ParseInfo(const std::uint8_t *, std::size_t), CaseList>(
+      << SwitcherFactory::Parse<ParseInfo(const std::uint8_t *, std::size_t, MidiEvent *), CaseList>(
         GetFirstByteMask<0xF0>,
         InvalidParse);
 
     static constexpr auto insight = pgm::Process<MidiSize(uint8_t)>()
       << allowMidi2Insight
-      << SwitcherFactory::Size<MidiSize(std::uint8_t), CaseList>(
-        u8Mask<0xF0>,
-        InvalidInsight);
+      << insightCases;
+
+    // Flattened first byte tables. insightTable ignores isMidi2Enabled(), methodTable entries honor it
+    static constexpr auto insightTable = SwitcherFactory::SizeTable(insightCases);
+    static constexpr auto methodTable = SwitcherFactory::Table<ParseInfo(const std::uint8_t *, std::size_t, MidiEvent *), typename CheckedList<CaseList>::type, 0xF0>(InvalidParse);
   };
 
 private:
-  using CaseList = std::tuple<
-    M1,
-    M2>;
+  static constexpr auto insightTable = SwitcherFactory::Overlay(M2::insightTable, M1::insightTable, M1::value, 0x80);
+  static constexpr auto methodTable = SwitcherFactory::Overlay(M2::methodTable, M1::methodTable, M1::value, 0x80);
 
 public:
-  [[maybe_unused]] static constexpr auto Interpret = pgm::Process<ParseInfo(const std::uint8_t *&, std::size_t &)>{}
+  // Single indirect call through the flattened first byte table
+  [[maybe_unused]] static constexpr auto Interpret = pgm::Process<ParseInfo(const std::uint8_t *&, std::size_t &, MidiEvent *)>{}
     << CheckLength<1>
-    << SwitcherFactory::Parse<ParseInfo(const std::uint8_t *, std::size_t), CaseList>(
-      GetFirstByteMask<0x80>,
-      InvalidParse);
+    << [](const std::uint8_t *bytes, std::size_t length, MidiEvent *out) { return methodTable[bytes[0]](bytes, length, out); };
+
+  // Single load from the flattened first byte table
+  [[maybe_unused]] static constexpr auto Insight = [](std::uint8_t byte) {
+    return (byte & M1::value) || M2::isMidi2Enabled() ? insightTable[byte] : MidiSize::Discard<1>();
+  };
 
-  [[maybe_unused]] static constexpr auto Insight = SwitcherFactory::Size<MidiSize(std::uint8_t), CaseList>(
-    u8Mask<0x80>,
-    InvalidInsight);
+  // Batch interpretation, defined in midi_batch.hpp
+  static constexpr BatchInfo InterpretBatch(const std::uint8_t *bytes, std::size_t length, MidiEvent *events, std::size_t capacity);
+  static constexpr BatchInfo InterpretBatch(const std::uint8_t *bytes, std::size_t length, MidiEvent *events, std::size_t capacity, std::uint8_t &running);
+  static constexpr BatchInfo InterpretWords(const std::uint32_t *words, std::size_t count, MidiEvent *events, std::size_t capacity);
 };
 
 #endif // MIDI_PARSER_HPP
@@ -0,0 +1,279 @@
+#ifndef MPE_HPP
+#define MPE_HPP
+
+/**
+ * @file mpe.hpp
+ * @author Etienne SANTOUL github.com/esantoul
+ * @brief MIDI Polyphonic Expression: zones & per note expression
+ * @version 0.1
+ * @date 2021-02-04
+ *
+ * @copyright BSD 2-Clause License. Copyright (c) 2021, Etienne SANTOUL. All rights reserved.
+ */
+
+#include "midi_event.hpp"
+#include "rpn_assembler.hpp"
+#include <cstddef>
+#include <cstdint>
+
+enum class MpeEventType : std::uint8_t
+{
+  NoteOn,
+  NoteOff,
+  PitchBend, // 14 bits, 8192 is the center
+  Timbre,    // CC 74, 7 bits
+  Pressure,  // channel pressure, 7 bits
+};
+
+/**
+ * @brief A note or expression update. Expression sent on a member channel is reported once per note sounding on it,
+ * expression sent on the manager channel applies to the whole zone & is reported with note ID 0
+ */
+struct MpeEvent
+{
+  MpeEventType type{};
+  std::uint8_t zone{};    // 0 lower, 1 upper
+  std::uint8_t channel{};
+  std::uint8_t note{};
+  std::uint32_t id{};     // unique note ID, 0 for zone wide expression
+  std::uint16_t value{};  // velocity for NoteOn & NoteOff, expression value otherwise
+};
+
+struct MpeZone
+{
+  std::uint8_t members{};              // member channels, 0 when the zone is disabled
+  std::uint8_t managerBendRange{2};    // semitones
+  std::uint8_t memberBendRange{48};    // semitones
+
+  // Lower zone: manager 0 & members 1..members, upper zone: manager 15 & members 15 - members..14
+  static constexpr std::uint8_t manager(std::uint8_t zone) { return zone ? 15 : 0; }
+};
+
+/**
+ * @brief Tracks the MPE zones of one MIDI 1.0 port, configured by the MPE Configuration Message (RPN 6 on a manager
+ * channel), and turns member channel notes & expression into per note events.
+ * Notes are kept in fixed arrays per member channel, events of channels outside of the zones are left to the caller.
+ * @tparam notes_per_channel Notes tracked per member channel, further note ons on a full channel are ignored
+ */
+template <std::size_t notes_per_channel = 4>
+class MpeProcessor
+{
+public:
+  constexpr MpeProcessor() { layout(); }
+
+  /**
+   * @brief Applies a decoded MIDI 1.0 event
+   * @param e decoded event
+   * @param onEvent callable invoked as onEvent(const MpeEvent &) for each note or expression update
+   * @param param set to the parameter change (RegistCtrl, AssignCtrl or their relative forms) completed by a zone
+   * channel control change when MPE does not handle it, type None otherwise. Parameter selections (CC 101/100/99/98)
+   * are consumed, the parameter they select comes back here
+   * @return true if the event was handled as MPE: zone configuration, RPN sequence or zone channel note & expression.
+   * Other events are left to the caller, parameter changes through `param`
+   */
+  template <typename EventFun_t>
+  constexpr bool feed(const MidiEvent &e, EventFun_t &&onEvent, MidiEvent &param)
+  {
+    param = MidiEvent{};
+    const std::uint8_t ch = e.channel & 0x0F;
+    // Only zone channels & the manager channels, which carry the MPE Configuration Message, are MPE
+    if (mZoneOf[ch] == none && ch != 0 && ch != 15)
+      return false;
+    if (e.type == EventType::ControlChange)
+    {
+      MidiEvent assembled{};
+      switch (mRpn.feed(e, assembled))
+      {
+      case RpnResult::Consumed:
+        return true;
+      case RpnResult::Emitted:
+        if (parameter(ch, assembled, e.data1 == 6))
+          return true;
+        param = assembled;
+        return false;
+      default:
+        break;
+      }
+      if (e.data1 != 74)
+        return false;
+    }
+
+    const std::uint8_t zone = mZoneOf[ch];
+    if (zone == none)
+      return false;
+    const bool manager = ch == MpeZone::manager(zone);
+    const std::uint16_t v = static_cast<std::uint16_t>(e.value);
+    switch (e.type)
+    {
+    case EventType::NoteOn:
+      if (manager)
+        return false;
+      if (!v)
+        return noteOff(zone, ch, e.data1, 0, onEvent);
+      return noteOn(zone, ch, e.data1, v, onEvent);
+    case EventType::NoteOff:
+      return !manager && noteOff(zone, ch, e.data1, v, onEvent);
+    case EventType::PitchBend:
+      return expression(zone, ch, manager, MpeEventType::PitchBend, v, onEvent);
+    case EventType::ControlChange:
+      return expression(zone, ch, manager, MpeEventType::Timbre, v, onEvent);
+    case EventType::ChannelPressure:
+      return expression(zone, ch, manager, MpeEventType::Pressure, v, onEvent);
+    default:
+      return false;
+    }
+  }
+
+  // feed() dropping the parameter changes MPE does not handle
+  template <typename EventFun_t>
+  constexpr bool feed(const MidiEvent &e, EventFun_t &&onEvent)
+  {
+    MidiEvent param{};
+    return feed(e, onEvent, param);
+  }
+
+  constexpr const MpeZone &zone(std::uint8_t zone) const { return mZones[zone & 1]; }
+
+  // Last expression values of a member channel, set before or during its notes
+  constexpr std::uint16_t bend(std::uint8_t channel) const { return mChannels[channel & 0x0F].bend; }
+  constexpr std::uint8_t timbre(std::uint8_t channel) const { return mChannels[channel & 0x0F].timbre; }
+  constexpr std::uint8_t pressure(std::uint8_t channel) const { return mChannels[channel & 0x0F].pressure; }
+
+  /**
+   * @brief Configures a zone as an MPE Configuration Message would
+   * @param zone 0 lower, 1 upper
+   * @param members member channels (0 disables the zone), the other zone shrinks if they overlap
+   */
+  constexpr void configure(std::uint8_t zone, std::uint8_t members)
+  {
+    zone &= 1;
+    mZones[zone].members = members > 15 ? 15 : members;
+    MpeZone &other = mZones[!zone];
+    if (other.members > 14 - mZones[zone].members)
+      other.members = mZones[zone].members >= 14 ? 0 : 14 - mZones[zone].members;
+    mZones[zone].managerBendRange = 2;
+    mZones[zone].memberBendRange = 48;
+    layout();
+  }
+
+  constexpr void reset()
+  {
+    mRpn.reset();
+    mZones[0] = mZones[1] = MpeZone{};
+    layout();
+  }
+
+private:
+  static constexpr std::uint8_t none = 0xFF;
+
+  struct Slot
+  {
+    std::uint32_t id{}; // 0 when free
+    std::uint8_t note{};
+  };
+
+  struct Channel
+  {
+    Slot notes[notes_per_channel]{};
+    std::uint16_t bend{8192};
+    std::uint8_t timbre{64};
+    std::uint8_t pressure{};
+  };
+
+  /**
+   * @brief Handles RPN 0 (pitch bend sensitivity) & RPN 6 (MPE configuration) of zone channels
+   * @param dataMsb whether the parameter was emitted by a data entry MSB (CC 6). The MCM is only applied then: the
+   * parameter is emitted again by a following LSB (CC 38), which must not reset the zone & its sounding notes
+   */
+  constexpr bool parameter(std::uint8_t ch, const MidiEvent &param, bool dataMsb)
+  {
+    if (param.type != EventType::RegistCtrl || param.data1 != 0)
+      return false;
+    const std::uint8_t msb = static_cast<std::uint8_t>(param.value >> 25);
+    if (param.data2 == 6 && (ch == 0 || ch == 15))
+    {
+      if (dataMsb)
+        configure(ch == 15, msb);
+      return true;
+    }
+    const std::uint8_t zone = mZoneOf[ch];
+    if (param.data2 != 0 || zone == none)
+      return false;
+    (ch == MpeZone::manager(zone) ? mZones[zone].managerBendRange : mZones[zone].memberBendRange) = msb;
+    return true;
+  }
+
+  // Maps channels to zones. A configuration change resets every channel, as MPE receivers must
+  constexpr void layout()
+  {
+    for (std::uint8_t c = 0; c < 16; ++c)
+      mZoneOf[c] = none;
+    for (std::uint8_t z = 0; z < 2; ++z)
+    {
+      const std::uint8_t n = mZones[z].members;
+      if (!n)
+        continue;
+      const std::uint8_t first = z ? 15 - n : 0;
+      for (std::uint8_t c = first; c <= first + n; ++c)
+        mZoneOf[c] = z;
+    }
+    for (std::uint8_t c = 0; c < 16; ++c)
+      mChannels[c] = Channel{};
+  }
+
+  template <typename EventFun_t>
+  constexpr bool noteOn(std::uint8_t zone, std::uint8_t ch, std::uint8_t note, std::uint16_t velocity, EventFun_t &onEvent)
+  {
+    for (Slot &s : mChannels[ch].notes)
+      if (!s.id)
+      {
+        s = Slot{mNextId, note};
+        mNextId = mNextId == UINT32_MAX ? 1 : mNextId + 1;
+        onEvent(MpeEvent{MpeEventType::NoteOn, zone, ch, note, s.id, velocity});
+        return true;
+      }
+    return true;
+  }
+
+  template <typename EventFun_t>
+  constexpr bool noteOff(std::uint8_t zone, std::uint8_t ch, std::uint8_t note, std::uint16_t velocity, EventFun_t &onEvent)
+  {
+    for (Slot &s : mChannels[ch].notes)
+      if (s.id && s.note == note)
+      {
+        onEvent(MpeEvent{MpeEventType::NoteOff, zone, ch, note, s.id, velocity});
+        s.id = 0;
+        break;
+      }
+    return true;
+  }
+
+  template <typename EventFun_t>
+  constexpr bool expression(std::uint8_t zone, std::uint8_t ch, bool manager, MpeEventType type, std::uint16_t v, EventFun_t &onEvent)
+  {
+    if (manager)
+    {
+      onEvent(MpeEvent{type, zone, ch, 0, 0, v});
+      return true;
+    }
+    Channel &c = mChannels[ch];
+    if (type == MpeEventType::PitchBend)
+      c.bend = v;
+    else if (type == MpeEventType::Timbre)
+      c.timbre = static_cast<std::uint8_t>(v);
+    else
+      c.pressure = static_cast<std::uint8_t>(v);
+    for (const Slot &s : c.notes)
+      if (s.id)
+        onEvent(MpeEvent{type, zone, ch, s.note, s.id, v});
+    return true;
+  }
+
+  RpnAssembler<1> mRpn;
+  MpeZone mZones[2]{};
+  std::uint8_t mZoneOf[16]{};
+  Channel mChannels[16]{};
+  std::uint32_t mNextId{1};
+};
+
+#endif // MPE_HPP
@@ -0,0 +1,249 @@
+#ifndef MTC_ASSEMBLER_HPP
+#define MTC_ASSEMBLER_HPP
+
+/**
+ * @file mtc_assembler.hpp
+ * @author Etienne SANTOUL github.com/esantoul
+ * @brief MIDI Time Code quarter frame & full frame assembly, published through a seqlock
+ * @version 0.1
+ * @date 2021-02-04
+ *
+ * @copyright BSD 2-Clause License. Copyright (c) 2021, Etienne SANTOUL. All rights reserved.
+ */
+
+#include "midi_event.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+enum class MtcRate : std::uint8_t
+{
+  Fps24 = 0,
+  Fps25 = 1,
+  Fps2997Drop = 2, // 30 fps drop frame
+  Fps30 = 3,
+};
+
+/**
+ * @brief hh:mm:ss:ff timecode & its conversion from/to a frame count (drop frame aware)
+ */
+struct Timecode
+{
+  std::uint8_t hours{};
+  std::uint8_t minutes{};
+  std::uint8_t seconds{};
+  std::uint8_t frames{};
+  MtcRate rate{};
+
+  static constexpr std::uint32_t framesPerSecond(MtcRate rate)
+  {
+    return rate == MtcRate::Fps24 ? 24 : (rate == MtcRate::Fps25 ? 25 : 30);
+  }
+
+  static constexpr std::uint32_t framesPerDay(MtcRate rate)
+  {
+    // Drop frame skips frames 0 & 1 of every minute except every tenth minute
+    return rate == MtcRate::Fps2997Drop ? 144 * 17982 : 86400 * framesPerSecond(rate);
+  }
+
+  static constexpr Timecode fromFrames(std::uint32_t count, MtcRate rate)
+  {
+    if (rate == MtcRate::Fps2997Drop)
+    {
+      const std::uint32_t tens = count / 17982;
+      const std::uint32_t rem = count % 17982;
+      count += 18 * tens + (rem > 1 ? 2 * ((rem - 2) / 1798) : 0);
+    }
+    const std::uint32_t fps = framesPerSecond(rate);
+    return {std::uint8_t(count / (3600 * fps) % 24), std::uint8_t(count / (60 * fps) % 60),
+            std::uint8_t(count / fps % 60), std::uint8_t(count % fps), rate};
+  }
+
+  constexpr std::uint32_t toFrames() const
+  {
+    const std::uint32_t fps = framesPerSecond(rate);
+    std::uint32_t count = ((hours * 60u + minutes) * 60u + seconds) * fps + frames;
+    if (rate == MtcRate::Fps2997Drop)
+    {
+      const std::uint32_t totalMinutes = hours * 60u + minutes;
+      count -= 2 * (totalMinutes - totalMinutes / 10);
+    }
+    return count;
+  }
+};
+
+/**
+ * @brief Position published by MtcAssembler
+ */
+struct MtcPosition
+{
+  std::uint32_t quarters{}; // quarter frames since 00:00:00:00
+  MtcRate rate{};
+  std::int8_t direction{}; // 1 forward, -1 reverse, 0 after a full frame message
+  bool locked{};           // a complete quarter frame sequence or a full frame message was received
+  std::int64_t time{};     // caller time of the last update
+
+  constexpr Timecode timecode() const { return Timecode::fromFrames(quarters / 4, rate); }
+  constexpr std::uint8_t quarter() const { return quarters % 4; }
+};
+
+/**
+ * @brief Assembles the MTC of one port from quarter frame messages (MIDI 1.0 0xF1 or UMP System) & full frame
+ * Universal Real Time SysEx, as decoded by MidiBytes.
+ * Quarter frames advance the position by one quarter frame in the detected direction, every complete sequence of
+ * eight pieces resynchronizes it & full frame messages relocate it immediately.
+ * A single thread updates the assembler, any number of threads read the position through a seqlock.
+ */
+class MtcAssembler
+{
+public:
+  MtcAssembler() = default;
+  MtcAssembler(const MtcAssembler &) = delete;
+  MtcAssembler &operator=(const MtcAssembler &) = delete;
+
+  /**
+   * @brief Applies a decoded event
+   * @param e MTC or UniversalRT event
+   * @param now caller time of the message, published with the position
+   * @return true if the event was an MTC quarter frame or full frame message
+   */
+  bool update(const MidiEvent &e, std::int64_t now = 0)
+  {
+    if (e.type == EventType::MTC)
+    {
+      quarterFrame(e.data1, now);
+      return true;
+    }
+    // Universal Real Time: 7F <device> 01 01 hr mn sc fr
+    if (e.type == EventType::UniversalRT && e.data2 == 0x01 && e.data16 == 0x01 && e.length >= 8)
+    {
+      fullFrame(e.payload + 4, now);
+      return true;
+    }
+    return false;
+  }
+
+  /**
+   * @brief Applies a quarter frame message
+   * @param data quarter frame data byte: 0nnn dddd, piece number & nibble
+   */
+  void quarterFrame(std::uint8_t data, std::int64_t now = 0)
+  {
+    const std::uint8_t piece = (data >> 4) & 0x07;
+    const std::uint32_t shift = 4 * piece;
+    mPieces = (mPieces & ~(std::uint32_t{0xF} << shift)) | std::uint32_t(data & 0x0F) << shift;
+
+    const std::int8_t step = piece == ((mPiece + 1) & 7) ? 1 : (piece == ((mPiece - 1) & 7) ? -1 : 0);
+    // Pieces in sequence, counting the previous one. 0 after a full frame so that the first piece does not advance
+    mSequence = step && mSequence ? (step == mDirection ? (mSequence < 8 ? mSequence + 1 : 8) : 2) : 1;
+    mDirection = step;
+    mPiece = piece;
+
+    if (mSequence >= 8 && piece == (step > 0 ? 7 : 0))
+    {
+      // Piece p of the sequence describing frame F is sent at quarter frame 4F + p, in both directions
+      const Timecode tc{std::uint8_t(mPieces >> 24 & 0x1F), std::uint8_t(mPieces >> 16 & 0x3F),
+                        std::uint8_t(mPieces >> 8 & 0x3F), std::uint8_t(mPieces & 0x1F), MtcRate(mPieces >> 29 & 0x03)};
+      mRate = tc.rate;
+      mDayQuarters = 4 * Timecode::framesPerDay(mRate);
+      mQuarters = (4 * tc.toFrames() + piece) % mDayQuarters;
+      mLocked = true;
+    }
+    else if (mLocked && mSequence > 1)
+      mQuarters = step > 0 ? (mQuarters + 1 == mDayQuarters ? 0 : mQuarters + 1) : (mQuarters ? mQuarters : mDayQuarters) - 1;
+    else
+      return;
+    publish(step, now);
+  }
+
+  /**
+   * @brief Applies a full frame message
+   * @param hmsf hours (0rrhhhhh, rr the frame rate), minutes, seconds & frames bytes
+   */
+  void fullFrame(const std::uint8_t *hmsf, std::int64_t now = 0)
+  {
+    const Timecode tc{std::uint8_t(hmsf[0] & 0x1F), std::uint8_t(hmsf[1] & 0x3F), std::uint8_t(hmsf[2] & 0x3F),
+                      std::uint8_t(hmsf[3] & 0x1F), MtcRate(hmsf[0] >> 5 & 0x03)};
+    mRate = tc.rate;
+    mDayQuarters = 4 * Timecode::framesPerDay(mRate);
+    mQuarters = 4 * tc.toFrames() % mDayQuarters;
+    mLocked = true;
+    // Quarter frames resume from piece 0 (or 7 in reverse) of the new position
+    mSequence = 0;
+    mDirection = 0;
+    mPiece = 7;
+    publish(0, now);
+  }
+
+  /**
+   * @brief Reads the current position, retrying while an update is in progress
+   */
+  MtcPosition read() const
+  {
+    MtcPosition p;
+    while (!tryRead(p))
+      ;
+    return p;
+  }
+
+  /**
+   * @brief Reads the current position without waiting
+   * @return false if an update was in progress
+   */
+  bool tryRead(MtcPosition &p) const
+  {
+    const std::uint32_t seq = mPublished.seq.load(std::memory_order_acquire);
+    if (seq & 1)
+      return false;
+    const std::uint64_t state = mPublished.state.load(std::memory_order_relaxed);
+    const std::int64_t time = mPublished.time.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (mPublished.seq.load(std::memory_order_relaxed) != seq)
+      return false;
+    p = MtcPosition{std::uint32_t(state), MtcRate(state >> 32 & 0x03), std::int8_t(state >> 40), bool(state >> 48 & 1), time};
+    return true;
+  }
+
+  void reset(std::int64_t now = 0)
+  {
+    mPieces = 0;
+    mQuarters = 0;
+    mSequence = 0;
+    mDirection = 0;
+    mPiece = 0;
+    mLocked = false;
+    publish(0, now);
+  }
+
+private:
+  void publish(std::int8_t direction, std::int64_t now)
+  {
+    const std::uint32_t seq = mPublished.seq.load(std::memory_order_relaxed);
+    mPublished.seq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    mPublished.state.store(mQuarters | std::uint64_t(mRate) << 32 | std::uint64_t(std::uint8_t(direction)) << 40 | std::uint64_t(mLocked) << 48,
+                           std::memory_order_relaxed);
+    mPublished.time.store(now, std::memory_order_relaxed);
+    mPublished.seq.store(seq + 2, std::memory_order_release);
+  }
+
+  // Writer state
+  std::uint32_t mPieces{}; // nibble of piece p at bits 4p..4p+3
+  std::uint32_t mQuarters{};
+  std::uint32_t mDayQuarters{4 * Timecode::framesPerDay(MtcRate::Fps24)};
+  std::uint8_t mSequence{};
+  std::int8_t mDirection{};
+  std::uint8_t mPiece{};
+  MtcRate mRate{};
+  bool mLocked{};
+
+  // Reader side, on its own cache line
+  struct alignas(64) Published
+  {
+    std::atomic<std::uint32_t> seq{0};
+    std::atomic<std::uint64_t> state{0};
+    std::atomic<std::int64_t> time{0};
+  } mPublished;
+};
+
+#endif // MTC_ASSEMBLER_HPP
@@ -0,0 +1,192 @@
+#ifndef PAYLOAD_VIEW_HPP
+#define PAYLOAD_VIEW_HPP
+
+/**
+ * @file payload_view.hpp
+ * @author Etienne SANTOUL github.com/esantoul
+ * @brief Non-owning views over SysEx & data message payloads, with an explicit copy for payloads outliving their buffer
+ * @version 0.1
+ * @date 2021-02-04
+ *
+ * @copyright BSD 2-Clause License. Copyright (c) 2021, Etienne SANTOUL. All rights reserved.
+ */
+
+#include "midi_event.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+
+/**
+ * @brief Bytes of an input buffer: the buffer start, an offset & a length.
+ * A view is only valid as long as its buffer is, keeping the buffer start makes that dependency checkable.
+ */
+class PayloadView
+{
+public:
+  constexpr PayloadView() = default;
+  constexpr PayloadView(const std::uint8_t *buffer, std::size_t offset, std::size_t length) : mBuffer{buffer}, mOffset{offset}, mLength{length} {}
+
+  /**
+   * @brief View of the payload of a decoded event (SysEx, Universal SysEx, SysEx7, SysEx8 & Mixed Data Set)
+   * @param buffer buffer given to MidiBytes::Interpret, the payload must point into it
+   */
+  static constexpr PayloadView of(const MidiEvent &e, const std::uint8_t *buffer)
+  {
+    return e.payload ? PayloadView{buffer, std::size_t(e.payload - buffer), e.length} : PayloadView{};
+  }
+
+  constexpr const std::uint8_t *buffer() const { return mBuffer; }
+  constexpr std::size_t offset() const { return mOffset; }
+  constexpr const std::uint8_t *data() const { return mBuffer + mOffset; }
+  constexpr std::size_t size() const { return mLength; }
+  constexpr bool empty() const { return !mLength; }
+  constexpr std::uint8_t operator[](std::size_t i) const { return mBuffer[mOffset + i]; }
+  constexpr const std::uint8_t *begin() const { return data(); }
+  constexpr const std::uint8_t *end() const { return data() + mLength; }
+
+  // Bytes [pos, pos + n) of the view, clamped to its end
+  constexpr PayloadView sub(std::size_t pos, std::size_t n = SIZE_MAX) const
+  {
+    pos = pos < mLength ? pos : mLength;
+    return {mBuffer, mOffset + pos, n < mLength - pos ? n : mLength - pos};
+  }
+
+  // Whether the view lies in the `size` bytes of `buffer`
+  constexpr bool within(const std::uint8_t *buffer, std::size_t size) const
+  {
+    return mBuffer == buffer && mOffset <= size && mLength <= size - mOffset;
+  }
+
+  // Same view over a copy of its buffer bytes starting at `buffer`
+  constexpr PayloadView rebase(const std::uint8_t *buffer) const { return {buffer, 0, mLength}; }
+
+private:
+  const std::uint8_t *mBuffer{};
+  std::size_t mOffset{};
+  std::size_t mLength{};
+};
+
+class PinnedSysEx;
+
+/**
+ * @brief Validated view of a SysEx body (the bytes between F0 & F7, from the ID byte).
+ * The ID form & the Universal SysEx header are resolved by the single validation pass of parse(), accessors do not re-read them.
+ */
+class SysExView
+{
+public:
+  static constexpr std::uint8_t NonRealTime = 0x7E;
+  static constexpr std::uint8_t RealTime = 0x7F;
+
+  constexpr SysExView() = default;
+
+  /**
+   * @brief Validates a SysEx: at least an ID, complete 3-byte IDs & Universal headers, no status byte in the body.
+   * A leading F0 & a trailing F7 are stripped
+   * @return an invalid (empty) view if validation fails
+   */
+  static constexpr SysExView parse(const std::uint8_t *buffer, std::size_t offset, std::size_t length)
+  {
+    if (length && buffer[offset] == 0xF0)
+      ++offset, --length;
+    if (length && buffer[offset + length - 1] == 0xF7)
+      --length;
+    if (!length || !dataBytes(buffer + offset, length))
+      return {};
+
+    const std::uint8_t id = buffer[offset];
+    const std::uint8_t header = id == 0x00 ? 3 : (id == NonRealTime || id == RealTime ? 4 : 1);
+    // Universal SysEx need the device ID & sub-ID#1, sub-ID#2 is optional
+    if (length < (header == 4 ? 3u : header))
+      return {};
+    return SysExView{PayloadView{buffer, offset, length}, static_cast<std::uint8_t>(header < length ? header : length)};
+  }
+
+  static constexpr SysExView parse(const std::uint8_t *bytes, std::size_t length) { return parse(bytes, 0, length); }
+
+  /**
+   * @brief View of a decoded SysEx or Universal SysEx event
+   * @param buffer buffer given to MidiBytes::Interpret
+   */
+  static constexpr SysExView of(const MidiEvent &e, const std::uint8_t *buffer)
+  {
+    if (e.type != EventType::SysEx && e.type != EventType::UniversalNonRT && e.type != EventType::UniversalRT)
+      return {};
+    const PayloadView p = PayloadView::of(e, buffer);
+    return parse(p.buffer(), p.offset(), p.size());
+  }
+
+  constexpr bool valid() const { return mHeader; }
+  constexpr explicit operator bool() const { return valid(); }
+
+  // The whole body, ID included
+  constexpr const PayloadView &payload() const { return mPayload; }
+  // The body after the manufacturer ID, or after the Universal SysEx device ID & sub-IDs
+  constexpr PayloadView data() const { return mPayload.sub(mHeader); }
+
+  constexpr bool universal() const { return mPayload[0] == NonRealTime || mPayload[0] == RealTime; }
+  constexpr bool realTime() const { return mPayload[0] == RealTime; }
+
+  /**
+   * @brief Manufacturer ID: the ID byte, or 0x00xxyy for 3-byte IDs. 0x7E & 0x7F for Universal SysEx
+   */
+  constexpr std::uint32_t manufacturerId() const
+  {
+    return mPayload[0] == 0x00 ? std::uint32_t(mPayload[1]) << 8 | mPayload[2] : mPayload[0];
+  }
+
+  // Universal SysEx header
+  constexpr std::uint8_t deviceId() const { return universal() ? mPayload[1] : 0; }
+  constexpr std::uint8_t subId1() const { return universal() ? mPayload[2] : 0; }
+  constexpr std::uint8_t subId2() const { return universal() && mPayload.size() > 3 ? mPayload[3] : 0; }
+
+  /**
+   * @brief Copies the body into caller storage, no allocation
+   * @param storage at least payload().size() bytes, must outlive the returned view
+   * @return the view over the copy
+   */
+  SysExView pin(std::uint8_t *storage) const
+  {
+    std::memcpy(storage, mPayload.data(), mPayload.size());
+    return SysExView{mPayload.rebase(storage), mHeader};
+  }
+
+  // Copies the body into owned storage
+  inline PinnedSysEx pin() const;
+
+private:
+  constexpr SysExView(const PayloadView &payload, std::uint8_t header) : mPayload{payload}, mHeader{header} {}
+
+  static constexpr bool dataBytes(const std::uint8_t *bytes, std::size_t length)
+  {
+    std::uint8_t acc = 0;
+    for (std::size_t i = 0; i < length; ++i)
+      acc |= bytes[i];
+    return !(acc & 0x80);
+  }
+
+  PayloadView mPayload;
+  std::uint8_t mHeader{}; // header bytes (1, 3 or 3-4 for Universal SysEx), 0 when invalid
+};
+
+/**
+ * @brief A SysEx copied out of its input buffer, for consumers keeping it past the buffer lifetime (move-only)
+ */
+class PinnedSysEx
+{
+public:
+  PinnedSysEx() = default;
+  explicit PinnedSysEx(const SysExView &view) : mData{new std::uint8_t[view.payload().size() ? view.payload().size() : 1]}, mView{view.pin(mData.get())} {}
+
+  const SysExView &view() const { return mView; }
+  const SysExView *operator->() const { return &mView; }
+
+private:
+  std::unique_ptr<std::uint8_t[]> mData;
+  SysExView mView;
+};
+
+inline PinnedSysEx SysExView::pin() const { return PinnedSysEx{*this}; }
+
+#endif // PAYLOAD_VIEW_HPP
@@ -0,0 +1,247 @@
+#ifndef PER_NOTE_STORE_HPP
+#define PER_NOTE_STORE_HPP
+
+/**
+ * @file per_note_store.hpp
+ * @author Etienne SANTOUL github.com/esantoul
+ * @brief MIDI 2.0 per note controller & per note pitch bend state
+ * @version 0.1
+ * @date 2021-02-04
+ *
+ * @copyright BSD 2-Clause License. Copyright (c) 2021, Etienne SANTOUL. All rights reserved.
+ */
+
+#include "midi_event.hpp"
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief A per note value reported by PerNoteStore::snapshot
+ */
+struct PerNoteValue
+{
+  std::uint8_t group;
+  std::uint8_t channel;
+  std::uint8_t note;
+  EventType type;     // RegistPerNoteCtrl, AssignPerNoteCtrl or PerNotePitchBend
+  std::uint8_t index; // controller index
+  std::uint32_t value;
+};
+
+/**
+ * @brief Per group, channel & note store of MIDI 2.0 per note controllers (registered & assignable) & pitch bend.
+ * Only notes that received a per note message own state: a 128-byte block taken from a fixed pool, holding the note
+ * pitch bend & up to `controllersPerNote` controllers, reached through a per channel note index.
+ * PerNoteManagement honors its flags: Detach (D) forgets the controllers of the note, Reset (S) sets them back to their
+ * defaults. Blocks of released notes (note off) are kept & only reclaimed when the pool runs out.
+ * @tparam groups Number of UMP groups
+ * @tparam max_notes Notes holding per note state at the same time
+ */
+template <std::size_t groups = 16, std::size_t max_notes = 256>
+class PerNoteStore
+{
+  static_assert(max_notes < 0xFFFF, "Too many notes");
+
+public:
+  static constexpr std::size_t controllersPerNote = 18;
+  static constexpr std::uint32_t bendCenter = 0x80000000;
+
+  constexpr PerNoteStore()
+  {
+    for (std::size_t i = 0; i < max_notes; ++i)
+      mFree[i] = static_cast<std::uint16_t>(max_notes - 1 - i);
+  }
+
+  /**
+   * @brief Applies a decoded MIDI 2.0 channel voice event
+   * @return true if the event was a per note message (or a note on/off of a note holding state)
+   */
+  constexpr bool update(const MidiEvent &e)
+  {
+    const std::uint8_t note = e.data1 & 0x7F;
+    switch (e.type)
+    {
+    case EventType::RegistPerNoteCtrl:
+    case EventType::AssignPerNoteCtrl:
+    {
+      Block *b = acquire(e.group, e.channel, note);
+      if (!b)
+        return true;
+      const std::uint16_t key = static_cast<std::uint16_t>((e.type == EventType::AssignPerNoteCtrl) << 8 | e.data2);
+      for (std::size_t i = 0; i < b->count; ++i)
+        if (b->keys[i] == key)
+        {
+          b->values[i] = e.value;
+          return true;
+        }
+      if (b->count < controllersPerNote)
+      {
+        b->keys[b->count] = key;
+        b->values[b->count++] = e.value;
+      }
+      else
+        ++mOverflow;
+      return true;
+    }
+    case EventType::PerNotePitchBend:
+      if (Block *b = acquire(e.group, e.channel, note))
+        b->bend = e.value;
+      return true;
+    case EventType::PerNoteManagement:
+      if (e.data2 & 0x02) // Detach
+        release(index(e.group, e.channel)[note]);
+      else if (e.data2 & 0x01) // Reset
+        if (Block *b = find(e.group, e.channel, note))
+          b->count = 0, b->bend = bendCenter;
+      return true;
+    case EventType::NoteOn:
+    case EventType::NoteOff:
+      if (Block *b = find(e.group, e.channel, note))
+      {
+        b->released = e.type == EventType::NoteOff;
+        return true;
+      }
+      return false;
+    default:
+      return false;
+    }
+  }
+
+  /**
+   * @brief Reads a per note controller
+   * @param type RegistPerNoteCtrl or AssignPerNoteCtrl
+   * @return false if the controller was not received for the note
+   */
+  constexpr bool controller(std::uint8_t group, std::uint8_t channel, std::uint8_t note, EventType type, std::uint8_t idx, std::uint32_t &value) const
+  {
+    const Block *b = find(group, channel, note);
+    const std::uint16_t key = static_cast<std::uint16_t>((type == EventType::AssignPerNoteCtrl) << 8 | idx);
+    for (std::size_t i = 0; b && i < b->count; ++i)
+      if (b->keys[i] == key)
+      {
+        value = b->values[i];
+        return true;
+      }
+    return false;
+  }
+
+  // Per note pitch bend, bendCenter when none was received
+  constexpr std::uint32_t pitchBend(std::uint8_t group, std::uint8_t channel, std::uint8_t note) const
+  {
+    const Block *b = find(group, channel, note);
+    return b ? b->bend : bendCenter;
+  }
+
+  /**
+   * @brief Writes every stored per note value (pitch bends that differ from the center & controllers), walking the pool
+   * @return the number of values written
+   */
+  constexpr std::size_t snapshot(PerNoteValue *out, std::size_t capacity) const
+  {
+    std::size_t n = 0;
+    for (std::size_t w = 0; w < (max_notes + 63) / 64; ++w)
+      for (std::uint64_t bits = mUsed[w]; bits; bits &= bits - 1)
+      {
+        const Block &b = mBlocks[64 * w + __builtin_ctzll(bits)];
+        if (b.bend != bendCenter && n < capacity)
+          out[n++] = PerNoteValue{b.group, b.channel, b.note, EventType::PerNotePitchBend, 0, b.bend};
+        for (std::size_t i = 0; i < b.count && n < capacity; ++i)
+          out[n++] = PerNoteValue{b.group, b.channel, b.note, b.keys[i] >> 8 ? EventType::AssignPerNoteCtrl : EventType::RegistPerNoteCtrl,
+                                  static_cast<std::uint8_t>(b.keys[i]), b.values[i]};
+      }
+    return n;
+  }
+
+  // Notes holding state
+  constexpr std::size_t active() const { return max_notes - mFreeCount; }
+  // Controllers ignored because their note already held controllersPerNote controllers
+  constexpr std::size_t overflow() const { return mOverflow; }
+  // Per note messages ignored because the pool had no block left, even after reclaiming released notes
+  constexpr std::size_t exhausted() const { return mExhausted; }
+
+  constexpr void reset()
+  {
+    for (std::size_t i = 0; i < max_notes; ++i)
+      if (mUsed[i / 64] >> (i % 64) & 1)
+        release(index(mBlocks[i].group, mBlocks[i].channel)[mBlocks[i].note]);
+  }
+
+private:
+  struct alignas(64) Block
+  {
+    std::uint32_t bend{bendCenter};
+    std::uint8_t group{};
+    std::uint8_t channel{};
+    std::uint8_t note{};
+    std::uint8_t count{};
+    bool released{};
+    std::uint16_t keys[controllersPerNote]{}; // assignable flag << 8 | controller index
+    std::uint32_t values[controllersPerNote]{};
+  };
+  static_assert(sizeof(Block) == 128, "A note block must span 2 cache lines");
+
+  // Block index + 1 of each note of a channel, 0 when the note holds no state
+  constexpr std::uint16_t *index(std::uint8_t group, std::uint8_t channel) { return mIndex[(group % groups) * 16 + (channel & 0x0F)]; }
+  constexpr const std::uint16_t *index(std::uint8_t group, std::uint8_t channel) const { return mIndex[(group % groups) * 16 + (channel & 0x0F)]; }
+
+  constexpr Block *find(std::uint8_t group, std::uint8_t channel, std::uint8_t note)
+  {
+    const std::uint16_t i = index(group, channel)[note & 0x7F];
+    return i ? &mBlocks[i - 1] : nullptr;
+  }
+
+  constexpr const Block *find(std::uint8_t group, std::uint8_t channel, std::uint8_t note) const
+  {
+    const std::uint16_t i = index(group, channel)[note & 0x7F];
+    return i ? &mBlocks[i - 1] : nullptr;
+  }
+
+  constexpr Block *acquire(std::uint8_t group, std::uint8_t channel, std::uint8_t note)
+  {
+    std::uint16_t &slot = index(group, channel)[note];
+    if (slot)
+      return &mBlocks[slot - 1];
+    if (!mFreeCount)
+      reclaim();
+    if (!mFreeCount)
+    {
+      ++mExhausted;
+      return nullptr;
+    }
+    const std::uint16_t i = mFree[--mFreeCount];
+    mUsed[i / 64] |= std::uint64_t{1} << (i % 64);
+    Block &b = mBlocks[i];
+    b = Block{};
+    b.group = static_cast<std::uint8_t>(group % groups), b.channel = channel & 0x0F, b.note = note;
+    slot = static_cast<std::uint16_t>(i + 1);
+    return &b;
+  }
+
+  constexpr void release(std::uint16_t &slot)
+  {
+    if (!slot)
+      return;
+    const std::uint16_t i = static_cast<std::uint16_t>(slot - 1);
+    mUsed[i / 64] &= ~(std::uint64_t{1} << (i % 64));
+    mFree[mFreeCount++] = i;
+    slot = 0;
+  }
+
+  // Frees the blocks of released notes
+  constexpr void reclaim()
+  {
+    for (std::size_t i = 0; i < max_notes; ++i)
+      if ((mUsed[i / 64] >> (i % 64) & 1) && mBlocks[i].released)
+        release(index(mBlocks[i].group, mBlocks[i].channel)[mBlocks[i].note]);
+  }
+
+  Block mBlocks[max_notes]{};
+  std::uint16_t mIndex[16 * groups][128]{};
+  std::uint64_t mUsed[(max_notes + 63) / 64]{};
+  std::uint16_t mFree[max_notes]{};
+  std::size_t mFreeCount{max_notes};
+  std::size_t mOverflow{};
+  std::size_t mExhausted{};
+};
+
+#endif // PER_NOTE_STORE_HPP
@@ -0,0 +1,165 @@
+#ifndef RPN_ASSEMBLER_HPP
+#define RPN_ASSEMBLER_HPP
+
+/**
+ * @file rpn_assembler.hpp
+ * @author Etienne SANTOUL github.com/esantoul
+ * @brief RPN & NRPN parameter changes assembled from MIDI 1.0 control change sequences
+ * @version 0.1
+ * @date 2021-02-04
+ *
+ * @copyright BSD 2-Clause License. Copyright (c) 2021, Etienne SANTOUL. All rights reserved.
+ */
+
+#include "midi_downconvert.hpp"
+#include "midi_event.hpp"
+#include <cstddef>
+#include <cstdint>
+
+enum class RpnResult : std::uint8_t
+{
+  Ignored,  // not a parameter control change, to be handled as a plain control change
+  Consumed, // parameter selection or incomplete data entry
+  Emitted,  // a parameter change was written
+};
+
+/**
+ * @brief Turns CC 101/100 (RPN) & 99/98 (NRPN) parameter selections followed by data entry (CC 6/38) or data
+ * increment/decrement (CC 96/97) into the MIDI 2.0 events they translate to:
+ * RegistCtrl & AssignCtrl (bank = parameter MSB, index = parameter LSB, 14-bit value upscaled to 32 bits), and
+ * RelativeRegistCtrl & RelativeAssignCtrl (signed 32-bit step of one 14-bit unit).
+ * Data entry MSB emits the value with the LSB received since the selection (0 if none), a following LSB emits the
+ * refined value. The null parameter (127/127) disables data entry until the next selection. 5 bytes of state per channel.
+ * @tparam groups Number of UMP groups tracked, 16 channels each
+ */
+template <std::size_t groups = 1>
+class RpnAssembler
+{
+public:
+  /**
+   * @brief Applies a decoded control change
+   * @param cc decoded event, of any protocol
+   * @param out parameter change, written when Emitted is returned
+   */
+  constexpr RpnResult feed(const MidiEvent &cc, MidiEvent &out)
+  {
+    if (cc.type != EventType::ControlChange)
+      return RpnResult::Ignored;
+
+    State &s = mStates[(cc.group % groups) * 16 + (cc.channel & 0x0F)];
+    const std::uint8_t v = static_cast<std::uint8_t>(cc.protocol == 2 ? cc.value >> 25 : cc.value & 0x7F);
+    switch (cc.data1)
+    {
+    case 101:
+    case 99:
+      select(s, cc.data1 == 101 ? Rpn : Nrpn);
+      s.paramMsb = v;
+      return RpnResult::Consumed;
+    case 100:
+    case 98:
+      select(s, cc.data1 == 100 ? Rpn : Nrpn);
+      s.paramLsb = v;
+      return RpnResult::Consumed;
+    case 6:
+      if (!active(s))
+        return RpnResult::Ignored;
+      s.dataMsb = v;
+      if (!(s.flags & LsbFirst))
+        s.dataLsb = 0;
+      s.flags = static_cast<std::uint8_t>((s.flags & ~LsbFirst) | HaveMsb);
+      return emit(s, cc, out);
+    case 38:
+      if (!active(s))
+        return RpnResult::Ignored;
+      s.dataLsb = v;
+      if (s.flags & HaveMsb)
+        return emit(s, cc, out);
+      s.flags |= LsbFirst;
+      return RpnResult::Consumed;
+    case 96:
+    case 97:
+    {
+      if (!active(s))
+        return RpnResult::Ignored;
+      const bool rpn = s.flags & Rpn;
+      out = MidiEvent{rpn ? EventType::RelativeRegistCtrl : EventType::RelativeAssignCtrl, 2, cc.group, cc.channel, s.paramMsb, s.paramLsb};
+      out.value = cc.data1 == 96 ? std::uint32_t{1} << 18 : std::uint32_t(-(std::int32_t{1} << 18));
+      return RpnResult::Emitted;
+    }
+    default:
+      return RpnResult::Ignored;
+    }
+  }
+
+  /**
+   * @brief Assembles a batch of decoded events in place: parameter changes replace the control changes that complete
+   * them & consumed control changes are removed. Other events are kept in order
+   * @return the number of events left
+   */
+  constexpr std::size_t feed(MidiEvent *events, std::size_t count)
+  {
+    std::size_t n = 0;
+    for (std::size_t i = 0; i < count; ++i)
+    {
+      MidiEvent out{};
+      switch (feed(events[i], out))
+      {
+      case RpnResult::Ignored:
+        events[n++] = events[i];
+        break;
+      case RpnResult::Emitted:
+        events[n++] = out;
+        break;
+      default:
+        break;
+      }
+    }
+    return n;
+  }
+
+  // Selected parameter of a channel, 0x7F7F when none
+  constexpr std::uint16_t parameter(std::uint8_t group, std::uint8_t channel) const
+  {
+    const State &s = mStates[(group % groups) * 16 + (channel & 0x0F)];
+    return static_cast<std::uint16_t>(s.paramMsb << 7 | s.paramLsb);
+  }
+
+  constexpr void reset()
+  {
+    for (State &s : mStates)
+      s = State{};
+  }
+
+private:
+  enum Flags : std::uint8_t
+  {
+    Rpn = 0x01,
+    Nrpn = 0x02,
+    HaveMsb = 0x04,  // data entry MSB received since the selection
+    LsbFirst = 0x08, // data entry LSB received before the MSB
+  };
+
+  struct State
+  {
+    std::uint8_t paramMsb{0x7F};
+    std::uint8_t paramLsb{0x7F};
+    std::uint8_t dataMsb{};
+    std::uint8_t dataLsb{};
+    std::uint8_t flags{};
+  };
+
+  static constexpr void select(State &s, Flags kind) { s.flags = kind; }
+
+  static constexpr bool active(const State &s) { return (s.flags & (Rpn | Nrpn)) && !(s.paramMsb == 0x7F && s.paramLsb == 0x7F); }
+
+  static constexpr RpnResult emit(const State &s, const MidiEvent &cc, MidiEvent &out)
+  {
+    out = MidiEvent{s.flags & Rpn ? EventType::RegistCtrl : EventType::AssignCtrl, 2, cc.group, cc.channel, s.paramMsb, s.paramLsb};
+    out.value = ValueScale::up(std::uint32_t(s.dataMsb) << 7 | s.dataLsb, 14, 32);
+    return RpnResult::Emitted;
+  }
+
+  State mStates[16 * groups]{};
+};
+
+#endif // RPN_ASSEMBLER_HPP
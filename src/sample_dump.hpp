@@ -0,0 +1,409 @@
+#ifndef SAMPLE_DUMP_HPP
+#define SAMPLE_DUMP_HPP
+
+/**
+ * @file sample_dump.hpp
+ * @author Etienne SANTOUL github.com/esantoul
+ * @brief MIDI Sample Dump Standard receiver: dump header, checksummed data packets unpacked to PCM & dump requests
+ * @version 0.1
+ * @date 2021-02-04
+ *
+ * @copyright BSD 2-Clause License. Copyright (c) 2021, Etienne SANTOUL. All rights reserved.
+ */
+
+#include "midi_parser.hpp"
+#include "payload_view.hpp"
+#include "simd_config.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+enum class SdsLoop : std::uint8_t
+{
+  Forward = 0x00,
+  Alternating = 0x01,
+  Off = 0x7F,
+};
+
+/**
+ * @brief Sample Dump Header (F0 7E cc 01 sl sh ee pl pm ph gl gm gh hl hm hh il im ih jj F7)
+ */
+struct SdsHeader
+{
+  std::uint16_t sample{};    // sample number
+  std::uint8_t bits{};       // sample format, 8 to 28 bits
+  SdsLoop loop{SdsLoop::Off};
+  std::uint32_t periodNs{};  // sample period
+  std::uint32_t length{};    // in samples
+  std::uint32_t loopStart{}; // sustain loop, in samples
+  std::uint32_t loopEnd{};
+
+  // Bytes of 7 bits holding a sample
+  constexpr std::size_t bytesPerSample() const { return (bits + 6u) / 7u; }
+  constexpr std::size_t samplesPerPacket() const { return 120 / bytesPerSample(); }
+
+  /**
+   * @brief Reads a header
+   * @return false if the SysEx is not a valid Sample Dump Header
+   */
+  static constexpr bool parse(const SysExView &sysex, SdsHeader &out)
+  {
+    const PayloadView &p = sysex.payload();
+    if (!sysex || p[0] != SysExView::NonRealTime || p.size() < 19 || p[2] != 0x01 || p[5] < 8 || p[5] > 28)
+      return false;
+    const auto read21 = [&p](std::size_t i) { return std::uint32_t(p[i]) | std::uint32_t(p[i + 1]) << 7 | std::uint32_t(p[i + 2]) << 14; };
+    out.sample = static_cast<std::uint16_t>(p[3] | p[4] << 7);
+    out.bits = p[5];
+    out.periodNs = read21(6);
+    out.length = read21(9);
+    out.loopStart = read21(12);
+    out.loopEnd = read21(15);
+    out.loop = p[18] == 0x00 || p[18] == 0x01 ? static_cast<SdsLoop>(p[18]) : SdsLoop::Off;
+    return true;
+  }
+};
+
+/**
+ * @brief Data packet kernels: checksum & sample unpacking.
+ * A sample of b bits is sent MSB first in (b + 6) / 7 bytes of 7 bits, left justified & offset binary (0 is the most
+ * negative value). It is unpacked to a signed sample left justified to 32 bits, so every format shares one PCM layout.
+ */
+struct SdsUnpack : NotInstantiable
+{
+  // XOR & OR of bytes: the checksum of a data packet once masked, & bit 7 set in `ors` if a byte is not a data byte
+  struct Sum
+  {
+    std::uint8_t xors{};
+    std::uint8_t ors{};
+  };
+
+  // XOR of the bytes, 7-bit checksum of a data packet once masked
+  static std::uint8_t checksum(const std::uint8_t *bytes, std::size_t length) { return sum(bytes, length).xors; }
+
+  // XOR & OR of the bytes in a single pass
+  static Sum sum(const std::uint8_t *bytes, std::size_t length)
+  {
+    std::size_t i = 0;
+    Sum s{};
+#if defined(MIDI_SIMD_SSE2)
+    Acc acc;
+#if defined(MIDI_SIMD_AVX2)
+    // Two independent accumulators keep two loads in flight
+    Acc acc1;
+    for (; i + 64 <= length; i += 64)
+    {
+      acc.add(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(bytes + i)));
+      acc1.add(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(bytes + i + 32)));
+    }
+    acc.add(acc1.x2, acc1.o2);
+#endif
+    for (; i + 16 <= length; i += 16)
+      acc.add(_mm_loadu_si128(reinterpret_cast<const __m128i *>(bytes + i)));
+    s = acc.reduce();
+#endif
+    for (; i < length; ++i)
+      s.xors ^= bytes[i], s.ors |= bytes[i];
+    return s;
+  }
+
+  /**
+   * @brief Unpacks `count` samples & sums the `available` bytes in the same pass, so that a data packet is read once.
+   * 16-bit (2 bytes per sample) & 28-bit (4 bytes) formats use SSE2 or AVX2, 21-bit (3 bytes) formats use AVX2
+   * @param available bytes readable from `data`, vector loads stay within them
+   * @param bits sample format, 8 to 28
+   * @param out signed samples left justified to 32 bits
+   * @return XOR & OR of the `available` bytes, whatever `count`
+   */
+  static Sum unpack(const std::uint8_t *data, std::size_t available, std::uint8_t bits, std::int32_t *out, std::size_t count)
+  {
+    const std::size_t n = (bits + 6u) / 7u;
+    const std::uint32_t mask = ~std::uint32_t{0} << (32 - bits);
+    std::size_t i = 0;
+    Sum s{};
+#if defined(MIDI_SIMD_AVX2)
+    Acc acc;
+    const __m256i m = _mm256_set1_epi32(static_cast<int>(mask));
+    if (n == 2)
+      for (; i + 8 <= count && 2 * i + 16 <= available; i += 8)
+      {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + 2 * i));
+        acc.add(v);
+        store(out + i, join(_mm256_cvtepu16_epi32(v), m));
+      }
+    else if (n == 3)
+    {
+      // 4 samples of 3 bytes per 128-bit lane, spread to one sample per 32-bit lane
+      const __m256i spread = _mm256_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1,
+                                              0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+      // The 24 bytes of 8 samples: all of lo, then bytes 4 to 11 of hi
+      const __m128i tail = _mm_setr_epi32(0, -1, -1, 0);
+      for (; i + 8 <= count && 3 * i + 28 <= available; i += 8)
+      {
+        const __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + 3 * i));
+        const __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + 3 * i + 12));
+        acc.add(lo);
+        acc.add(_mm_and_si128(hi, tail));
+        store(out + i, join(_mm256_shuffle_epi8(_mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1), spread), m));
+      }
+    }
+    else if (n == 4)
+      for (; i + 8 <= count && 4 * i + 32 <= available; i += 8)
+      {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + 4 * i));
+        acc.add(v);
+        store(out + i, join(v, m));
+      }
+    s = acc.reduce();
+#elif defined(MIDI_SIMD_SSE2)
+    Acc acc;
+    const __m128i m = _mm_set1_epi32(static_cast<int>(mask));
+    if (n == 2)
+      for (; i + 8 <= count && 2 * i + 16 <= available; i += 8)
+      {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + 2 * i));
+        acc.add(v);
+        store(out + i, join(_mm_unpacklo_epi16(v, _mm_setzero_si128()), m));
+        store(out + i + 4, join(_mm_unpackhi_epi16(v, _mm_setzero_si128()), m));
+      }
+    else if (n == 4)
+      for (; i + 4 <= count && 4 * i + 16 <= available; i += 4)
+      {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + 4 * i));
+        acc.add(v);
+        store(out + i, join(v, m));
+      }
+    s = acc.reduce();
+#endif
+    for (std::size_t k = n * i; i < count; ++i)
+    {
+      std::uint32_t v = 0;
+      for (std::size_t b = 0; b < n; ++b, ++k)
+      {
+        v |= std::uint32_t(data[k] & 0x7F) << (25 - 7 * b);
+        s.xors ^= data[k], s.ors |= data[k];
+      }
+      out[i] = static_cast<std::int32_t>((v & mask) ^ 0x80000000);
+    }
+    // Bytes past the samples, e.g. the end of the last packet of a dump
+    const std::size_t used = n * count < available ? n * count : available;
+    const Sum rest = sum(data + used, available - used);
+    return {std::uint8_t(s.xors ^ rest.xors), std::uint8_t(s.ors | rest.ors)};
+  }
+
+private:
+#if defined(MIDI_SIMD_SSE2)
+  // XOR & OR accumulators of the vector loads
+  struct Acc
+  {
+    __m128i x = _mm_setzero_si128();
+    __m128i o = _mm_setzero_si128();
+#if defined(MIDI_SIMD_AVX2)
+    __m256i x2 = _mm256_setzero_si256();
+    __m256i o2 = _mm256_setzero_si256();
+
+    void add(__m256i v) { x2 = _mm256_xor_si256(x2, v), o2 = _mm256_or_si256(o2, v); }
+    void add(__m256i vx, __m256i vo) { x2 = _mm256_xor_si256(x2, vx), o2 = _mm256_or_si256(o2, vo); }
+#endif
+    void add(__m128i v) { x = _mm_xor_si128(x, v), o = _mm_or_si128(o, v); }
+
+    void add(__m128i vx, __m128i vo) { x = _mm_xor_si128(x, vx), o = _mm_or_si128(o, vo); }
+
+    Sum reduce()
+    {
+#if defined(MIDI_SIMD_AVX2)
+      add(_mm_xor_si128(_mm256_castsi256_si128(x2), _mm256_extracti128_si256(x2, 1)),
+          _mm_or_si128(_mm256_castsi256_si128(o2), _mm256_extracti128_si256(o2, 1)));
+#endif
+      add(_mm_srli_si128(x, 8), _mm_srli_si128(o, 8));
+      add(_mm_srli_si128(x, 4), _mm_srli_si128(o, 4));
+      add(_mm_srli_si128(x, 2), _mm_srli_si128(o, 2));
+      add(_mm_srli_si128(x, 1), _mm_srli_si128(o, 1));
+      return {static_cast<std::uint8_t>(_mm_cvtsi128_si32(x)), static_cast<std::uint8_t>(_mm_cvtsi128_si32(o))};
+    }
+  };
+#endif
+
+  // Each 32-bit lane holds the bytes of a sample, first byte lowest: b0 << 25 | b1 << 18 | b2 << 11 | b3 << 4, masked & sign flipped
+#if defined(MIDI_SIMD_AVX2)
+  static __m256i join(__m256i x, __m256i mask)
+  {
+    const __m256i b = _mm256_set1_epi32(0x7F);
+    const __m256i v = _mm256_or_si256(
+      _mm256_or_si256(_mm256_slli_epi32(_mm256_and_si256(x, b), 25), _mm256_slli_epi32(_mm256_and_si256(x, _mm256_slli_epi32(b, 8)), 10)),
+      _mm256_or_si256(_mm256_srli_epi32(_mm256_and_si256(x, _mm256_slli_epi32(b, 16)), 5), _mm256_srli_epi32(_mm256_and_si256(x, _mm256_slli_epi32(b, 24)), 20)));
+    return _mm256_xor_si256(_mm256_and_si256(v, mask), _mm256_set1_epi32(INT32_MIN));
+  }
+
+  static void store(std::int32_t *out, __m256i v) { _mm256_storeu_si256(reinterpret_cast<__m256i *>(out), v); }
+#elif defined(MIDI_SIMD_SSE2)
+  static __m128i join(__m128i x, __m128i mask)
+  {
+    const __m128i b = _mm_set1_epi32(0x7F);
+    const __m128i v = _mm_or_si128(
+      _mm_or_si128(_mm_slli_epi32(_mm_and_si128(x, b), 25), _mm_slli_epi32(_mm_and_si128(x, _mm_slli_epi32(b, 8)), 10)),
+      _mm_or_si128(_mm_srli_epi32(_mm_and_si128(x, _mm_slli_epi32(b, 16)), 5), _mm_srli_epi32(_mm_and_si128(x, _mm_slli_epi32(b, 24)), 20)));
+    return _mm_xor_si128(_mm_and_si128(v, mask), _mm_set1_epi32(INT32_MIN));
+  }
+
+  static void store(std::int32_t *out, __m128i v) { _mm_storeu_si128(reinterpret_cast<__m128i *>(out), v); }
+#endif
+};
+
+enum class SdsStatus : std::uint8_t
+{
+  Ignored,    // not a sample dump message
+  Invalid,    // malformed message, or data packet without a header
+  Header,     // dump header read, the dump starts
+  Packet,     // data packet unpacked, to be acknowledged (ACK)
+  Complete,   // last data packet unpacked
+  Checksum,   // data packet checksum mismatch, no received sample changed, to be refused (NAK)
+  OutOfOrder, // unexpected packet number, nothing written
+  Request,    // dump request, see requested()
+};
+
+/**
+ * @brief Receives a sample dump into a caller provided sample buffer.
+ * Each data packet (F0 7E cc 02 kk <120 bytes> ll F7) is validated, checksummed & unpacked in a single read, straight
+ * from the input buffer (feed it raw bytes or a decoded event, a SysExView has already been scanned once). Packets must follow the running packet number; the packet right before the expected one is
+ * taken as a retransmission & unpacked again in place. Samples past the buffer capacity are counted, not written.
+ */
+class SampleDumpDecoder
+{
+public:
+  /**
+   * @param samples buffer receiving the samples, signed & left justified to 32 bits
+   * @param capacity samples the buffer holds
+   */
+  constexpr SampleDumpDecoder(std::int32_t *samples, std::size_t capacity) : mSamples{samples}, mCapacity{capacity} {}
+
+  SdsStatus feed(const SysExView &sysex)
+  {
+    if (!sysex || sysex.payload()[0] != SysExView::NonRealTime)
+      return SdsStatus::Ignored;
+    switch (sysex.subId1())
+    {
+    case 0x01:
+      if (!SdsHeader::parse(sysex, mHeader))
+        return SdsStatus::Invalid;
+      mHaveHeader = true;
+      mReceived = mOverflow = mStart = 0;
+      mNext = 0;
+      mPackets = 0;
+      return SdsStatus::Header;
+    case 0x02:
+      return packet(sysex.payload().data(), sysex.payload().size());
+    case 0x03:
+      if (sysex.payload().size() < 5)
+        return SdsStatus::Invalid;
+      mRequested = static_cast<std::uint16_t>(sysex.payload()[3] | sysex.payload()[4] << 7);
+      return SdsStatus::Request;
+    default:
+      return SdsStatus::Ignored;
+    }
+  }
+
+  /**
+   * @brief Feeds a SysEx, leading F0 & trailing F7 optional. Data packets skip SysExView::parse, the unpack kernel checks
+   * their status bits
+   */
+  SdsStatus feed(const std::uint8_t *bytes, std::size_t length)
+  {
+    const std::uint8_t *p = bytes;
+    std::size_t size = length;
+    if (size && p[0] == 0xF0)
+      ++p, --size;
+    if (size && p[size - 1] == 0xF7)
+      --size;
+    if (size == 125 && p[0] == SysExView::NonRealTime && p[2] == 0x02)
+      return packet(p, size);
+    return feed(SysExView::parse(bytes, length));
+  }
+
+  /**
+   * @brief Feeds a decoded Universal SysEx event
+   * @param buffer buffer given to MidiBytes::Interpret
+   */
+  SdsStatus feed(const MidiEvent &e, const std::uint8_t *buffer)
+  {
+    if (e.type != EventType::UniversalNonRT || !e.payload)
+      return feed(SysExView::of(e, buffer));
+    return feed(e.payload, e.length);
+  }
+
+  constexpr const SdsHeader &header() const { return mHeader; }
+  // Samples received (written & overflowed)
+  constexpr std::size_t received() const { return mReceived + mOverflow; }
+  // Samples that did not fit in the buffer
+  constexpr std::size_t overflow() const { return mOverflow; }
+  constexpr bool complete() const { return mHaveHeader && received() >= mHeader.length; }
+  // Number of the last accepted packet, for ACK/NAK
+  constexpr std::uint8_t packet() const { return static_cast<std::uint8_t>((mNext - 1) & 0x7F); }
+  // Sample number of the last dump request
+  constexpr std::uint16_t requested() const { return mRequested; }
+
+  constexpr void reset()
+  {
+    mHeader = SdsHeader{};
+    mHaveHeader = false;
+    mReceived = mOverflow = mStart = 0;
+    mNext = 0;
+    mPackets = 0;
+  }
+
+private:
+  // p: 7E cc 02 kk <120 bytes> ll, status bits not checked yet
+  SdsStatus packet(const std::uint8_t *p, std::size_t size)
+  {
+    const std::uint8_t kk = p[3];
+    const bool again = mPackets && kk == ((mNext - 1) & 0x7F);
+    if (!mHaveHeader || size < 125 || (kk != mNext && !again))
+    {
+      // Not a SysEx at all if it holds a status byte, as SysExView::parse would tell
+      if (SdsUnpack::sum(p, size).ors & 0x80)
+        return SdsStatus::Ignored;
+      return mHaveHeader && size >= 125 ? SdsStatus::OutOfOrder : SdsStatus::Invalid;
+    }
+
+    const std::size_t at = again ? mStart : received();
+    const std::size_t left = mHeader.length > at ? mHeader.length - at : 0;
+    const std::size_t count = left < mHeader.samplesPerPacket() ? left : mHeader.samplesPerPacket();
+    const std::size_t room = mCapacity > at ? mCapacity - at : 0;
+    const std::size_t written = count < room ? count : room;
+    // Checked & unpacked in one pass: a fresh packet lands past the received samples, a retransmission goes through a
+    // copy so that a bad one leaves the accepted samples alone
+    std::int32_t copy[120];
+    const SdsUnpack::Sum s = SdsUnpack::unpack(p + 4, 120, mHeader.bits, again || !written ? copy : mSamples + at, written);
+    const std::uint8_t x = s.xors ^ p[0] ^ p[1] ^ p[2] ^ p[3];
+    std::uint8_t o = s.ors | p[0] | p[1] | p[2] | p[3];
+    for (std::size_t i = 124; i < size; ++i)
+      o |= p[i];
+    if (o & 0x80)
+      return SdsStatus::Ignored;
+    if ((x & 0x7F) != p[124])
+      return SdsStatus::Checksum;
+    if (again)
+      std::copy(copy, copy + written, mSamples + at);
+    else
+    {
+      mStart = at;
+      mReceived += written;
+      mOverflow += count - written;
+      mNext = (kk + 1) & 0x7F;
+      ++mPackets;
+    }
+    return complete() ? SdsStatus::Complete : SdsStatus::Packet;
+  }
+
+  std::int32_t *mSamples;
+  std::size_t mCapacity;
+  SdsHeader mHeader{};
+  bool mHaveHeader{};
+  std::size_t mReceived{};
+  std::size_t mOverflow{};
+  std::size_t mStart{}; // first sample of the last accepted packet
+  std::uint32_t mNext{}; // expected packet number
+  std::size_t mPackets{};
+  std::uint16_t mRequested{};
+};
+
+#endif // SAMPLE_DUMP_HPP
@@ -0,0 +1,32 @@
+#ifndef SIMD_CONFIG_HPP
+#define SIMD_CONFIG_HPP
+
+/**
+ * @file simd_config.hpp
+ * @author Etienne SANTOUL github.com/esantoul
+ * @brief Instruction set selection for the vectorized kernels. Define MIDI_SIMD_DISABLE to force the scalar fallbacks
+ * @version 0.1
+ * @date 2021-02-04
+ *
+ * @copyright BSD 2-Clause License. Copyright (c) 2021, Etienne SANTOUL. All rights reserved.
+ */
+
+#ifndef MIDI_SIMD_DISABLE
+
+#if defined(__AVX2__)
+#define MIDI_SIMD_AVX2
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MIDI_SIMD_SSE2
+#endif
+
+#endif // MIDI_SIMD_DISABLE
+
+#if defined(MIDI_SIMD_AVX2)
+#include <immintrin.h>
+#elif defined(MIDI_SIMD_SSE2)
+#include <emmintrin.h>
+#endif
+
+#endif // SIMD_CONFIG_HPP
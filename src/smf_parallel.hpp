@@ -0,0 +1,210 @@
+#ifndef SMF_PARALLEL_HPP
+#define SMF_PARALLEL_HPP
+
+/**
+ * @file smf_parallel.hpp
+ * @author Etienne SANTOUL github.com/esantoul
+ * @brief Multi-threaded Standard MIDI File decoding & time-ordered track merging
+ * @version 0.1
+ * @date 2021-02-04
+ *
+ * @copyright BSD 2-Clause License. Copyright (c) 2021, Etienne SANTOUL. All rights reserved.
+ */
+
+#include "smf_reader.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Loser tree merging tick-ordered event runs.
+ * Events with equal ticks come out in run order, then in their order inside the run.
+ */
+class SmfMerge
+{
+public:
+  using Run = std::vector<SmfEvent>;
+
+  /**
+   * @brief Merges the runs into `out` (appended)
+   */
+  static void merge(const std::vector<Run> &runs, std::vector<SmfEvent> &out)
+  {
+    std::size_t total = 0;
+    for (const Run &r : runs)
+      total += r.size();
+    out.reserve(out.size() + total);
+
+    SmfMerge m{runs};
+    for (std::size_t w = m.mTree[0]; !m.exhausted(w); w = m.pop())
+    {
+      // Runs are read in an order the hardware prefetcher does not follow past a few runs
+      if (m.mHead[w] + 8 < runs[w].size())
+        __builtin_prefetch(runs[w].data() + m.mHead[w] + 8);
+      out.push_back(runs[w][m.mHead[w]]);
+    }
+  }
+
+private:
+  explicit SmfMerge(const std::vector<Run> &runs) : mRuns{runs}, mHead(runs.size()), mKey(runs.size()), mTree(runs.size() ? runs.size() : 1)
+  {
+    const std::size_t k = mRuns.size();
+    for (std::size_t i = 0; i < k; ++i)
+      mKey[i] = key(i);
+    if (!k)
+    {
+      mTree[0] = 0;
+      return;
+    }
+    // Leaves are the nodes k..2k-1, node n plays between 2n & 2n+1 and keeps the loser
+    std::vector<std::size_t> winner(2 * k);
+    for (std::size_t i = 0; i < k; ++i)
+      winner[k + i] = i;
+    for (std::size_t n = k - 1; n > 0; --n)
+    {
+      const std::size_t a = winner[2 * n];
+      const std::size_t b = winner[2 * n + 1];
+      winner[n] = less(b, a) ? b : a;
+      mTree[n] = less(b, a) ? a : b;
+    }
+    mTree[0] = winner[1];
+  }
+
+  bool exhausted(std::size_t run) const { return run >= mRuns.size() || mHead[run] == mRuns[run].size(); }
+
+  std::uint64_t key(std::size_t run) const { return exhausted(run) ? UINT64_MAX : mRuns[run][mHead[run]].tick; }
+
+  // Compares the cached head ticks, replays only touch the flat key array
+  bool less(std::size_t a, std::size_t b) const { return mKey[a] < mKey[b] || (mKey[a] == mKey[b] && a < b); }
+
+  // Advances the current winner & replays its path to the root
+  std::size_t pop()
+  {
+    std::size_t w = mTree[0];
+    ++mHead[w];
+    mKey[w] = key(w);
+    for (std::size_t n = (w + mRuns.size()) / 2; n > 0; n /= 2)
+      if (less(mTree[n], w))
+        std::swap(mTree[n], w);
+    return mTree[0] = w;
+  }
+
+  const std::vector<Run> &mRuns;
+  std::vector<std::size_t> mHead;
+  std::vector<std::uint64_t> mKey; // head tick of each run, UINT64_MAX once exhausted
+  std::vector<std::size_t> mTree; // mTree[0] is the winner
+};
+
+struct SmfParallel : NotInstantiable
+{
+  /**
+   * @brief Decodes every track into its own event buffer, tracks are distributed over worker threads
+   * @param file parsed file
+   * @param tracks output buffers, one per track. Events point into the file data, running status messages
+   * have their `data` cleared (use the decoded `event`)
+   * @param threads number of workers, 0 for the hardware concurrency
+   * @return SUCCESS or the error of the first failing track (its events up to the error are kept)
+   */
+  template <std::size_t max_tracks>
+  static SmfInfo decodeTracks(const SmfFile<max_tracks> &file, std::vector<SmfMerge::Run> &tracks, unsigned threads = 0)
+  {
+    const std::size_t count = file.tracks();
+    tracks.assign(count, {});
+    std::vector<SmfInfo> status(count);
+
+    std::atomic<std::size_t> next{0};
+    auto work = [&] {
+      for (std::size_t t = next++; t < count; t = next++)
+        status[t] = decodeTrack(file.track(t), static_cast<std::uint16_t>(t), tracks[t]);
+    };
+    run(work, workers(threads, count));
+
+    for (const SmfInfo &s : status)
+      if (s.status() != SMF_STATUS::SUCCESS)
+        return s;
+    return {SMF_STATUS::SUCCESS};
+  }
+
+  /**
+   * @brief Decodes every track in parallel & merges them into one tick-ordered stream
+   */
+  template <std::size_t max_tracks>
+  static SmfInfo decode(const SmfFile<max_tracks> &file, std::vector<SmfEvent> &events, unsigned threads = 0)
+  {
+    std::vector<SmfMerge::Run> tracks;
+    const SmfInfo ret = decodeTracks(file, tracks, threads);
+    events.clear();
+    SmfMerge::merge(tracks, events);
+    return ret;
+  }
+
+  /**
+   * @brief Decodes a batch of files, one file per worker at a time.
+   * @param paths file paths
+   * @param count number of files
+   * @param onFile called from the workers (concurrently) as `onFile(index, SmfInfo, const std::vector<SmfEvent> &)`
+   * with the merged events of each file. Event data points into the file mapping and is only valid during the call
+   * @param threads number of workers, 0 for the hardware concurrency
+   */
+  template <typename Callback_t, std::size_t max_tracks = 256>
+  static void decodeFiles(const char *const *paths, std::size_t count, Callback_t &&onFile, unsigned threads = 0)
+  {
+    std::atomic<std::size_t> next{0};
+    auto work = [&] {
+      SmfFile<max_tracks> file;
+      std::vector<SmfEvent> events;
+      for (std::size_t i = next++; i < count; i = next++)
+      {
+        events.clear();
+        SmfInfo ret = file.open(paths[i]);
+        if (ret.status() == SMF_STATUS::SUCCESS)
+          ret = decode(file, events, 1);
+        onFile(i, ret, static_cast<const std::vector<SmfEvent> &>(events));
+      }
+    };
+    run(work, workers(threads, count));
+  }
+
+private:
+  static SmfInfo decodeTrack(const SmfTrack &track, std::uint16_t idx, SmfMerge::Run &events)
+  {
+    // Channel messages are 2 to 3 bytes with a 1 byte delta time
+    events.reserve(track.size() / 3);
+    SmfTrack::Cursor cursor{track};
+    SmfEvent e;
+    SmfInfo ret;
+    while ((ret = cursor.next(e)).status() == SMF_STATUS::SUCCESS)
+    {
+      e.track = idx;
+      if (e.data < track.data() || e.data >= track.data() + track.size())
+        e.data = nullptr;
+      events.push_back(e);
+    }
+    return ret ? ret : SmfInfo{SMF_STATUS::SUCCESS};
+  }
+
+  static unsigned workers(unsigned threads, std::size_t jobs)
+  {
+    if (!threads)
+      threads = std::thread::hardware_concurrency() ? std::thread::hardware_concurrency() : 1;
+    return jobs < threads ? static_cast<unsigned>(jobs) : threads;
+  }
+
+  // Runs `work` on `n` threads, the calling thread being one of them
+  template <typename Work_t>
+  static void run(Work_t &work, unsigned n)
+  {
+    std::vector<std::thread> pool;
+    for (unsigned i = 1; i < n; ++i)
+      pool.emplace_back(std::ref(work));
+    if (n)
+      work();
+    for (std::thread &t : pool)
+      t.join();
+  }
+};
+
+#endif // SMF_PARALLEL_HPP
@@ -0,0 +1,351 @@
+#ifndef SMF_READER_HPP
+#define SMF_READER_HPP
+
+/**
+ * @file smf_reader.hpp
+ * @author Etienne SANTOUL github.com/esantoul
+ * @brief Zero-copy Standard MIDI File reader
+ * @version 0.1
+ * @date 2021-02-04
+ *
+ * @copyright BSD 2-Clause License. Copyright (c) 2021, Etienne SANTOUL. All rights reserved.
+ */
+
+#include "info_types.hpp"
+#include "mapped_file.hpp"
+#include "midi_decode.hpp"
+#include "midi_parser.hpp"
+#include "static_vector.h"
+#include <cstddef>
+#include <cstdint>
+
+enum class SMF_STATUS
+{
+  UNDEFINED = 0, // no more events
+  SUCCESS,
+  ERROR_OPEN,
+  ERROR_HEADER,
+  ERROR_TOO_MANY_TRACKS,
+  ERROR_TRUNCATED,
+  ERROR_INVALID_STATUS,
+};
+
+using SmfInfo = utils::info<SMF_STATUS>;
+
+enum class SmfEventType : std::uint8_t
+{
+  Midi,        // channel message
+  SysEx,       // F0 event
+  SysExEscape, // F7 event: SysEx continuation or raw bytes
+  Meta,        // meta event without a dedicated type
+  Tempo,
+  TimeSignature,
+  EndOfTrack,
+};
+
+struct SmfTimeSignature
+{
+  std::uint8_t numerator;
+  std::uint8_t denominatorPow2; // denominator = 1 << denominatorPow2
+  std::uint8_t clocksPerClick;
+  std::uint8_t notated32ndsPerQuarter;
+};
+
+/**
+ * @brief An event read from a track chunk.
+ * `data` points into the file, except for running status channel messages whose bytes are rebuilt
+ * in the cursor (valid until the next event is read).
+ */
+struct SmfEvent
+{
+  std::uint64_t tick{}; // absolute time from the track start, in division units
+  std::uint32_t delta{};
+  SmfEventType type{};
+  std::uint8_t metaType{};
+  std::uint16_t track{}; // index of the track in the file, set when tracks are decoded together
+  std::uint32_t length{};
+  // Midi: message including its status byte, SysEx: bytes after F0 & the length (F7 included),
+  // SysExEscape & meta events: event data after the length
+  const std::uint8_t *data{};
+  // Midi & SysEx terminated by F7: the MidiBytes decoded message, type None otherwise
+  MidiEvent event{};
+
+  // Tempo in microseconds per quarter note
+  constexpr std::uint32_t tempo() const { return std::uint32_t(data[0]) << 16 | std::uint32_t(data[1]) << 8 | data[2]; }
+  constexpr SmfTimeSignature timeSignature() const { return {data[0], data[1], data[2], data[3]}; }
+};
+
+struct Vlq : NotInstantiable
+{
+  /**
+   * @brief Reads a variable length quantity (at most 4 bytes)
+   * @param pos read position, advanced past the quantity
+   * @param end end of the readable bytes
+   * @param value read value
+   * @return false if the quantity is truncated or longer than 4 bytes
+   */
+  static constexpr bool read(const std::uint8_t *&pos, const std::uint8_t *end, std::uint32_t &value)
+  {
+    value = 0;
+    for (int i = 0; i < 4 && pos < end; ++i)
+    {
+      const std::uint8_t b = *pos++;
+      value = value << 7 | (b & 0x7F);
+      if (!(b & 0x80))
+        return true;
+    }
+    return false;
+  }
+
+  /**
+   * @brief Writes a variable length quantity
+   * @param value value, at most 28 bits
+   * @param out output, at least 4 bytes
+   * @return the number of bytes written
+   */
+  static constexpr std::size_t write(std::uint32_t value, std::uint8_t *out)
+  {
+    std::size_t n = 1;
+    for (std::uint32_t v = value >> 7; v; v >>= 7)
+      ++n;
+    for (std::size_t i = n; i-- > 0; value >>= 7)
+      out[i] = static_cast<std::uint8_t>((value & 0x7F) | (i + 1 < n ? 0x80 : 0));
+    return n;
+  }
+};
+
+/**
+ * @brief Content of an MTrk chunk
+ */
+class SmfTrack
+{
+public:
+  constexpr SmfTrack() = default;
+  constexpr SmfTrack(const std::uint8_t *data, std::size_t size) : mData{data}, mSize{size} {}
+
+  constexpr const std::uint8_t *data() const { return mData; }
+  constexpr std::size_t size() const { return mSize; }
+
+  /**
+   * @brief Sequential event reader reporting framing errors
+   */
+  class Cursor
+  {
+  public:
+    constexpr Cursor() = default;
+    constexpr explicit Cursor(const SmfTrack &track) : mPos{track.mData}, mEnd{track.mData + track.mSize} {}
+
+    /**
+     * @brief Reads the next event
+     * @return SUCCESS, UNDEFINED after the end of track (meta event or end of chunk) or the framing error
+     */
+    constexpr SmfInfo next(SmfEvent &e)
+    {
+      if (mPos >= mEnd)
+        return {};
+
+      e = SmfEvent{};
+      if (!Vlq::read(mPos, mEnd, e.delta) || mPos >= mEnd)
+        return fail(SMF_STATUS::ERROR_TRUNCATED);
+      mTick += e.delta;
+      e.tick = mTick;
+
+      const std::uint8_t b = *mPos;
+      if (b == 0xFF || b == 0xF0 || b == 0xF7)
+        return sysexOrMeta(e);
+
+      const std::uint8_t status = b & 0x80 ? b : mRunning;
+      const MidiSize sz = MidiBytes::M1::insight(status);
+      if (status < 0x80 || status >= 0xF0 || sz.status() != MidiSize::Status::Set)
+        return fail(SMF_STATUS::ERROR_INVALID_STATUS);
+
+      e.type = SmfEventType::Midi;
+      e.length = static_cast<std::uint32_t>(sz.value());
+      if (b & 0x80)
+      {
+        if (std::size_t(mEnd - mPos) < e.length)
+          return fail(SMF_STATUS::ERROR_TRUNCATED);
+        e.data = mPos;
+        mPos += e.length;
+      }
+      else
+      {
+        // Running status: rebuild the message so that the parser sees its status byte
+        if (std::size_t(mEnd - mPos) < e.length - 1)
+          return fail(SMF_STATUS::ERROR_TRUNCATED);
+        mBuffer[0] = status;
+        for (std::size_t i = 1; i < e.length; ++i)
+          mBuffer[i] = *mPos++;
+        e.data = mBuffer;
+      }
+      mRunning = status;
+      MidiBytes::Interpret(e.data, e.length, &e.event);
+      return {SMF_STATUS::SUCCESS};
+    }
+
+  private:
+    constexpr SmfInfo fail(SMF_STATUS s)
+    {
+      mPos = mEnd;
+      return {s};
+    }
+
+    constexpr SmfInfo sysexOrMeta(SmfEvent &e)
+    {
+      const std::uint8_t b = *mPos++;
+      if (b == 0xFF)
+      {
+        if (mPos >= mEnd)
+          return fail(SMF_STATUS::ERROR_TRUNCATED);
+        e.metaType = *mPos++;
+      }
+      if (!Vlq::read(mPos, mEnd, e.length) || std::size_t(mEnd - mPos) < e.length)
+        return fail(SMF_STATUS::ERROR_TRUNCATED);
+      e.data = mPos;
+      mPos += e.length;
+
+      if (b == 0xF0)
+      {
+        e.type = SmfEventType::SysEx;
+        mRunning = 0;
+        // The parser strips one leading byte & the trailing F7: hand it the message from the last length byte
+        if (e.length && e.data[e.length - 1] == 0xF7)
+        {
+          const std::uint8_t *bytes = e.data - 1;
+          std::size_t length = e.length + 1;
+          MidiBytes::M1::SystemMessage::SysEx::method(bytes, length, &e.event);
+        }
+      }
+      else if (b == 0xF7)
+      {
+        e.type = SmfEventType::SysExEscape;
+        mRunning = 0;
+      }
+      else if (e.metaType == 0x51 && e.length >= 3)
+        e.type = SmfEventType::Tempo;
+      else if (e.metaType == 0x58 && e.length >= 4)
+        e.type = SmfEventType::TimeSignature;
+      else if (e.metaType == 0x2F)
+      {
+        e.type = SmfEventType::EndOfTrack;
+        mPos = mEnd;
+      }
+      else
+        e.type = SmfEventType::Meta;
+      // Meta events keep the running status: files relying on it are common
+      return {SMF_STATUS::SUCCESS};
+    }
+
+    const std::uint8_t *mPos{};
+    const std::uint8_t *mEnd{};
+    std::uint64_t mTick{};
+    std::uint8_t mRunning{};
+    std::uint8_t mBuffer[3]{};
+  };
+
+  /**
+   * @brief Event iterator, stops at the end of track or at the first framing error (use a Cursor to get it)
+   */
+  class iterator
+  {
+  public:
+    constexpr iterator() = default;
+    constexpr explicit iterator(const SmfTrack &track) : mCursor{track} { ++*this; }
+
+    constexpr const SmfEvent &operator*() const { return mEvent; }
+    constexpr const SmfEvent *operator->() const { return &mEvent; }
+    constexpr iterator &operator++()
+    {
+      mDone = mCursor.next(mEvent).status() != SMF_STATUS::SUCCESS;
+      return *this;
+    }
+    constexpr bool operator!=(const iterator &other) const { return mDone != other.mDone; }
+
+  private:
+    Cursor mCursor{};
+    SmfEvent mEvent{};
+    bool mDone{true};
+  };
+
+  constexpr iterator begin() const { return iterator{*this}; }
+  constexpr iterator end() const { return {}; }
+
+private:
+  const std::uint8_t *mData{};
+  std::size_t mSize{};
+};
+
+/**
+ * @brief Standard MIDI File: header & track chunks, read either from a memory-mapped file or from memory.
+ * Chunks other than MThd & MTrk are skipped.
+ * @tparam max_tracks Maximum number of tracks
+ */
+template <std::size_t max_tracks = 256>
+class SmfFile
+{
+public:
+  SmfFile() = default;
+
+  /**
+   * @brief Maps a file & reads its chunk structure
+   */
+  SmfInfo open(const char *path)
+  {
+    mTracks.clear();
+    if (!mFile.open(path))
+      return {SMF_STATUS::ERROR_OPEN};
+    return parse(mFile.data(), mFile.size());
+  }
+
+  /**
+   * @brief Reads the chunk structure of a file in memory. The buffer must outlive the tracks
+   */
+  constexpr SmfInfo parse(const std::uint8_t *data, std::size_t size)
+  {
+    mTracks.clear();
+    if (size < 14 || !isChunk(data, "MThd") || ReadBE32(data + 4) < 6)
+      return {SMF_STATUS::ERROR_HEADER};
+
+    mFormat = ReadBE16(data + 8);
+    mTrackCount = ReadBE16(data + 10);
+    mDivision = ReadBE16(data + 12);
+    if (mFormat > 2 || (mFormat == 0 && mTrackCount != 1))
+      return {SMF_STATUS::ERROR_HEADER};
+
+    std::size_t pos = 8 + std::size_t(ReadBE32(data + 4));
+    while (pos + 8 <= size && mTracks.size() < mTrackCount)
+    {
+      const std::size_t len = ReadBE32(data + pos + 4);
+      if (len > size - pos - 8)
+        return {SMF_STATUS::ERROR_TRUNCATED};
+      if (isChunk(data + pos, "MTrk"))
+      {
+        if (mTracks.size() == max_tracks)
+          return {SMF_STATUS::ERROR_TOO_MANY_TRACKS};
+        mTracks.push_back(SmfTrack{data + pos + 8, len});
+      }
+      pos += 8 + len;
+    }
+    return mTracks.size() == mTrackCount ? SmfInfo{SMF_STATUS::SUCCESS} : SmfInfo{SMF_STATUS::ERROR_TRUNCATED};
+  }
+
+  constexpr std::uint16_t format() const { return mFormat; }
+  // Ticks per quarter note, or SMPTE format (negative high byte) & ticks per frame when bit 15 is set
+  constexpr std::uint16_t division() const { return mDivision; }
+  constexpr std::size_t tracks() const { return mTracks.size(); }
+  constexpr SmfTrack track(std::size_t idx) const { return mTracks.begin()[idx]; }
+
+private:
+  static constexpr bool isChunk(const std::uint8_t *bytes, const char (&id)[5])
+  {
+    return bytes[0] == id[0] && bytes[1] == id[1] && bytes[2] == id[2] && bytes[3] == id[3];
+  }
+
+  MappedFile mFile;
+  std::uint16_t mFormat{};
+  std::uint16_t mTrackCount{};
+  std::uint16_t mDivision{};
+  utils::StaticVector<SmfTrack, max_tracks> mTracks;
+};
+
+#endif // SMF_READER_HPP
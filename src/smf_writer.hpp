@@ -0,0 +1,326 @@
+#ifndef SMF_WRITER_HPP
+#define SMF_WRITER_HPP
+
+/**
+ * @file smf_writer.hpp
+ * @author Etienne SANTOUL github.com/esantoul
+ * @brief Standard MIDI File writer
+ * @version 0.1
+ * @date 2021-02-04
+ *
+ * @copyright BSD 2-Clause License. Copyright (c) 2021, Etienne SANTOUL. All rights reserved.
+ */
+
+#include "midi_encode.hpp"
+#include "smf_reader.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <unistd.h>
+#include <vector>
+
+// Output sinks: write(bytes, n), offset() (bytes written so far), patch(offset, bytes, n) & ok()
+
+/**
+ * @brief Growable in-memory output
+ */
+class SmfVectorSink
+{
+public:
+  explicit SmfVectorSink(std::size_t reserve = 0) { mBytes.reserve(reserve); }
+
+  void write(const std::uint8_t *bytes, std::size_t n) { mBytes.insert(mBytes.end(), bytes, bytes + n); }
+  std::size_t offset() const { return mBytes.size(); }
+  void patch(std::size_t offset, const std::uint8_t *bytes, std::size_t n) { std::memcpy(mBytes.data() + offset, bytes, n); }
+  bool ok() const { return true; }
+
+  const std::vector<std::uint8_t> &bytes() const { return mBytes; }
+  std::vector<std::uint8_t> &bytes() { return mBytes; }
+
+private:
+  std::vector<std::uint8_t> mBytes;
+};
+
+/**
+ * @brief Preallocated output, writes past the capacity are dropped & reported by ok()
+ */
+class SmfBufferSink
+{
+public:
+  constexpr SmfBufferSink(std::uint8_t *data, std::size_t capacity) : mData{data}, mCapacity{capacity} {}
+
+  void write(const std::uint8_t *bytes, std::size_t n)
+  {
+    if (n > mCapacity - mSize)
+    {
+      mOverflow = true;
+      return;
+    }
+    std::memcpy(mData + mSize, bytes, n);
+    mSize += n;
+  }
+  constexpr std::size_t offset() const { return mSize; }
+  // No-op once writes were dropped: the patched chunk lengths would be wrong anyway
+  void patch(std::size_t offset, const std::uint8_t *bytes, std::size_t n)
+  {
+    if (mOverflow || offset > mCapacity || n > mCapacity - offset)
+      return;
+    std::memcpy(mData + offset, bytes, n);
+  }
+  constexpr bool ok() const { return !mOverflow; }
+
+private:
+  std::uint8_t *mData;
+  std::size_t mCapacity;
+  std::size_t mSize{};
+  bool mOverflow{};
+};
+
+/**
+ * @brief File descriptor output through a large buffer. Data is written at the descriptor position
+ * at construction. Lengths already flushed are patched with pwrite, which needs a seekable descriptor.
+ * @tparam buffer_size Write buffer size
+ */
+template <std::size_t buffer_size = std::size_t{1} << 20>
+class SmfFdSink
+{
+public:
+  explicit SmfFdSink(int fd) : mFd{fd}, mBase{::lseek(fd, 0, SEEK_CUR)}, mBuffer{new std::uint8_t[buffer_size]} {}
+  SmfFdSink(const SmfFdSink &) = delete;
+  SmfFdSink &operator=(const SmfFdSink &) = delete;
+  ~SmfFdSink() { flush(); }
+
+  void write(const std::uint8_t *bytes, std::size_t n)
+  {
+    if (n > buffer_size - mSize)
+    {
+      flush();
+      if (n >= buffer_size)
+      {
+        writeAll(bytes, n);
+        return;
+      }
+    }
+    std::memcpy(mBuffer.get() + mSize, bytes, n);
+    mSize += n;
+  }
+
+  std::size_t offset() const { return mFlushed + mSize; }
+
+  void patch(std::size_t offset, const std::uint8_t *bytes, std::size_t n)
+  {
+    if (offset >= mFlushed)
+    {
+      std::memcpy(mBuffer.get() + (offset - mFlushed), bytes, n);
+      return;
+    }
+    if (offset + n > mFlushed) // straddles the buffer start
+      flush();
+    if (mBase < 0 || ::pwrite(mFd, bytes, n, mBase + static_cast<off_t>(offset)) != static_cast<ssize_t>(n))
+      mError = true;
+  }
+
+  void flush()
+  {
+    writeAll(mBuffer.get(), mSize);
+    mSize = 0;
+  }
+
+  bool ok() const { return !mError; }
+
+private:
+  void writeAll(const std::uint8_t *bytes, std::size_t n)
+  {
+    mFlushed += n;
+    while (n && !mError)
+    {
+      const ssize_t w = ::write(mFd, bytes, n);
+      if (w <= 0)
+        mError = true;
+      else
+        bytes += w, n -= static_cast<std::size_t>(w);
+    }
+  }
+
+  int mFd;
+  off_t mBase;
+  std::unique_ptr<std::uint8_t[]> mBuffer;
+  std::size_t mSize{};
+  std::size_t mFlushed{};
+  bool mError{};
+};
+
+/**
+ * @brief Writes a Standard MIDI File into a sink: header(), then for each track beginTrack(), events & endTrack().
+ * Channel messages use running status, SysEx & meta events cancel it. Track chunk lengths are patched by endTrack().
+ * @tparam Sink_t SmfVectorSink, SmfBufferSink, SmfFdSink or any type with the same interface
+ */
+template <typename Sink_t>
+class SmfWriter
+{
+public:
+  explicit SmfWriter(Sink_t &sink) : mSink{sink} {}
+
+  /**
+   * @brief Writes the MThd chunk
+   * @param format 0, 1 or 2
+   * @param tracks number of tracks that will be written
+   * @param division ticks per quarter note, or SMPTE division
+   */
+  void header(std::uint16_t format, std::uint16_t tracks, std::uint16_t division)
+  {
+    const std::uint8_t h[14] = {'M', 'T', 'h', 'd', 0, 0, 0, 6,
+                                std::uint8_t(format >> 8), std::uint8_t(format),
+                                std::uint8_t(tracks >> 8), std::uint8_t(tracks),
+                                std::uint8_t(division >> 8), std::uint8_t(division)};
+    mSink.write(h, sizeof h);
+  }
+
+  void beginTrack()
+  {
+    const std::uint8_t h[8] = {'M', 'T', 'r', 'k', 0, 0, 0, 0};
+    mTrackStart = mSink.offset();
+    mSink.write(h, sizeof h);
+    mRunning = 0;
+    mTick = 0;
+  }
+
+  /**
+   * @brief Writes the end of track meta event & patches the chunk length
+   */
+  void endTrack(std::uint32_t delta = 0)
+  {
+    meta(delta, 0x2F, nullptr, 0);
+    // Chunk header dropped by the sink, ok() reports it
+    if (mSink.offset() < mTrackStart + 8)
+      return;
+    const std::uint32_t len = static_cast<std::uint32_t>(mSink.offset() - mTrackStart - 8);
+    const std::uint8_t be[4] = {std::uint8_t(len >> 24), std::uint8_t(len >> 16), std::uint8_t(len >> 8), std::uint8_t(len)};
+    mSink.patch(mTrackStart + 4, be, sizeof be);
+  }
+
+  /**
+   * @brief Writes a MIDI 1.0 channel message
+   * @param delta delta time in ticks
+   * @param bytes message including its status byte
+   * @param length message length (2 or 3)
+   */
+  void message(std::uint32_t delta, const std::uint8_t *bytes, std::size_t length)
+  {
+    std::uint8_t buf[4 + 3];
+    std::size_t n = Vlq::write(delta, buf);
+    const bool running = bytes[0] == mRunning;
+    for (std::size_t i = running; i < length && i < 3; ++i)
+      buf[n++] = bytes[i];
+    mRunning = bytes[0];
+    mTick += delta;
+    mSink.write(buf, n);
+  }
+
+  /**
+   * @brief Writes a decoded MIDI 1.0 event (protocol 1): channel voice messages & SysEx (including Universal SysEx).
+   * Other events have no Standard MIDI File representation and are ignored
+   */
+  void event(std::uint32_t delta, const MidiEvent &e)
+  {
+    if (e.type == EventType::SysEx || e.type == EventType::UniversalNonRT || e.type == EventType::UniversalRT)
+      return sysex(delta, e.payload, e.length);
+    if (e.type < EventType::NoteOff || e.type >= EventType::SysEx)
+      return;
+
+    std::uint8_t m[3]{};
+    if (const std::size_t len = MidiEncode::m1(e, m))
+      message(delta, m, len);
+  }
+
+  /**
+   * @brief Writes an event read by SmfTrack at its absolute tick (symmetric to the reader)
+   */
+  void event(const SmfEvent &e)
+  {
+    const std::uint32_t delta = static_cast<std::uint32_t>(e.tick > mTick ? e.tick - mTick : 0);
+    switch (e.type)
+    {
+    case SmfEventType::Midi:
+      return e.data ? message(delta, e.data, e.length) : event(delta, e.event);
+    case SmfEventType::SysEx:
+      return raw(delta, 0xF0, e.data, e.length);
+    case SmfEventType::SysExEscape:
+      return raw(delta, 0xF7, e.data, e.length);
+    case SmfEventType::EndOfTrack:
+      return;
+    default:
+      return meta(delta, e.metaType, e.data, e.length);
+    }
+  }
+
+  /**
+   * @brief Writes a complete SysEx message
+   * @param body message bytes between F0 & F7
+   */
+  void sysex(std::uint32_t delta, const std::uint8_t *body, std::size_t length)
+  {
+    std::uint8_t buf[4 + 1 + 4];
+    std::size_t n = Vlq::write(delta, buf);
+    buf[n++] = 0xF0;
+    n += Vlq::write(static_cast<std::uint32_t>(length + 1), buf + n);
+    mSink.write(buf, n);
+    if (length)
+      mSink.write(body, length);
+    const std::uint8_t eox = 0xF7;
+    mSink.write(&eox, 1);
+    mRunning = 0;
+    mTick += delta;
+  }
+
+  void meta(std::uint32_t delta, std::uint8_t type, const std::uint8_t *data, std::size_t length)
+  {
+    std::uint8_t buf[4 + 2 + 4];
+    std::size_t n = Vlq::write(delta, buf);
+    buf[n++] = 0xFF;
+    buf[n++] = type & 0x7F;
+    n += Vlq::write(static_cast<std::uint32_t>(length), buf + n);
+    mSink.write(buf, n);
+    if (length)
+      mSink.write(data, length);
+    mRunning = 0;
+    mTick += delta;
+  }
+
+  void tempo(std::uint32_t delta, std::uint32_t usPerQuarter)
+  {
+    const std::uint8_t d[3] = {std::uint8_t(usPerQuarter >> 16), std::uint8_t(usPerQuarter >> 8), std::uint8_t(usPerQuarter)};
+    meta(delta, 0x51, d, sizeof d);
+  }
+
+  void timeSignature(std::uint32_t delta, const SmfTimeSignature &ts)
+  {
+    const std::uint8_t d[4] = {ts.numerator, ts.denominatorPow2, ts.clocksPerClick, ts.notated32ndsPerQuarter};
+    meta(delta, 0x58, d, sizeof d);
+  }
+
+  bool ok() const { return mSink.ok(); }
+
+private:
+  // F0 or F7 event with its data as stored in the file
+  void raw(std::uint32_t delta, std::uint8_t status, const std::uint8_t *data, std::size_t length)
+  {
+    std::uint8_t buf[4 + 1 + 4];
+    std::size_t n = Vlq::write(delta, buf);
+    buf[n++] = status;
+    n += Vlq::write(static_cast<std::uint32_t>(length), buf + n);
+    mSink.write(buf, n);
+    if (length)
+      mSink.write(data, length);
+    mRunning = 0;
+    mTick += delta;
+  }
+
+  Sink_t &mSink;
+  std::size_t mTrackStart{};
+  std::uint64_t mTick{};
+  std::uint8_t mRunning{};
+};
+
+#endif // SMF_WRITER_HPP
@@ -0,0 +1,210 @@
+#ifndef STATUS_SCANNER_HPP
+#define STATUS_SCANNER_HPP
+
+/**
+ * @file status_scanner.hpp
+ * @author Etienne SANTOUL github.com/esantoul
+ * @brief Bulk MIDI 1.0 framing: vectorized status byte scanning & message length validation
+ * @version 0.1
+ * @date 2021-02-04
+ *
+ * @copyright BSD 2-Clause License. Copyright (c) 2021, Etienne SANTOUL. All rights reserved.
+ */
+
+#include "midi_parser.hpp"
+#include "simd_config.hpp"
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Bitmaps describing a MIDI 1.0 byte buffer, one bit per input byte (bit i % 64 of word i / 64).
+ * Each bitmap must hold StatusScanner::words(length) words.
+ */
+struct StatusBitmaps
+{
+  std::uint64_t *status;   // bytes >= 0x80
+  std::uint64_t *sysex;    // 0xF0 & 0xF7 SysEx delimiters
+  std::uint64_t *realtime; // bytes >= 0xF8
+};
+
+struct StatusScanner : NotInstantiable
+{
+  static constexpr std::size_t words(std::size_t length) { return (length + 63) / 64; }
+
+  /**
+   * @brief Fills the status, SysEx delimiter & realtime bitmaps of a buffer in a single pass
+   * @param bytes input buffer
+   * @param length number of bytes in the input buffer
+   * @param maps output bitmaps
+   */
+  static void scan(const std::uint8_t *bytes, std::size_t length, const StatusBitmaps &maps)
+  {
+    const std::size_t full = length / 64;
+    for (std::size_t w = 0; w < full; ++w)
+      scanBlock(bytes + 64 * w, maps.status[w], maps.sysex[w], maps.realtime[w]);
+
+    if (length % 64)
+    {
+      std::uint64_t st{}, sx{}, rt{};
+      for (std::size_t i = 64 * full; i < length; ++i)
+        classify(bytes[i], i % 64, st, sx, rt);
+      maps.status[full] = st;
+      maps.sysex[full] = sx;
+      maps.realtime[full] = rt;
+    }
+  }
+
+  /**
+   * @brief Writes the offsets of the set bits of a bitmap
+   * @param bitmap bitmap produced by scan()
+   * @param length number of bytes described by the bitmap
+   * @param offsets output offset list
+   * @param max capacity of the offset list
+   * @return the number of offsets written
+   */
+  static std::size_t offsets(const std::uint64_t *bitmap, std::size_t length, std::uint32_t *offsets, std::size_t max)
+  {
+    std::size_t n = 0;
+    for (std::size_t w = 0; w < words(length) && n < max; ++w)
+      for (std::uint64_t bits = bitmap[w]; bits && n < max; bits &= bits - 1)
+        offsets[n++] = static_cast<std::uint32_t>(64 * w + __builtin_ctzll(bits));
+    return n;
+  }
+
+  /**
+   * @brief Walks the status bitmap and flags the bytes that break MIDI 1.0 message framing:
+   * data bytes outside of any message (running status is honored for channel messages),
+   * status bytes of messages interrupted before their last data byte, stray EOX & undefined status bytes.
+   * Realtime bytes are allowed anywhere, SysEx data is accepted up to the next non realtime status byte.
+   * @param bytes input buffer
+   * @param length number of bytes in the input buffer
+   * @param status status bitmap produced by scan()
+   * @param errors output bitmap of flagged bytes, StatusScanner::words(length) words
+   * @return the number of flagged bytes
+   */
+  static std::size_t validate(const std::uint8_t *bytes, std::size_t length, const std::uint64_t *status, std::uint64_t *errors)
+  {
+    for (std::size_t w = 0; w < words(length); ++w)
+      errors[w] = 0;
+
+    std::size_t flagged = 0;
+    std::size_t need = 0;    // data bytes still expected by the current message
+    std::size_t running = 0; // data bytes per message when running status applies
+    std::size_t current = 0; // offset of the current message status byte
+    bool inSysEx = false;
+
+    auto flag = [&](std::size_t from, std::size_t count) {
+      flagged += count;
+      for (; count; ++from, --count)
+        errors[from / 64] |= std::uint64_t{1} << (from % 64);
+    };
+
+    // Consumes `count` data bytes starting at `from`
+    auto data = [&](std::size_t from, std::size_t count) {
+      if (inSysEx || !count)
+        return;
+      const std::size_t k = count < need ? count : need;
+      need -= k, from += k, count -= k;
+      if (!count)
+        return;
+      if (running)
+        need = (running - count % running) % running;
+      else
+        flag(from, count);
+    };
+
+    std::size_t prev = 0; // first offset not yet accounted for
+    for (std::size_t w = 0; w < words(length); ++w)
+      for (std::uint64_t bits = status[w]; bits; bits &= bits - 1)
+      {
+        const std::size_t pos = 64 * w + __builtin_ctzll(bits);
+        const std::uint8_t b = bytes[pos];
+        data(prev, pos - prev);
+        prev = pos + 1;
+
+        if (b >= 0xF8)
+        {
+          if (MidiBytes::M1::insight(b).status() != MidiSize::Status::Set)
+            flag(pos, 1);
+          continue;
+        }
+        if (need)
+          flag(current, 1);
+        need = 0;
+
+        if (b == 0xF7)
+        {
+          if (!inSysEx)
+            flag(pos, 1);
+          inSysEx = false;
+          continue;
+        }
+        inSysEx = false;
+        current = pos;
+
+        const MidiSize sz = MidiBytes::M1::insight(b);
+        switch (sz.status())
+        {
+        case MidiSize::Status::Set:
+          need = sz.value() - 1;
+          running = b < 0xF0 ? need : 0;
+          break;
+        case MidiSize::Status::SysEx:
+          inSysEx = true;
+          running = 0;
+          break;
+        default:
+          running = 0;
+          flag(pos, 1);
+          break;
+        }
+      }
+    data(prev, length - prev);
+    return flagged;
+  }
+
+private:
+  static void classify(std::uint8_t b, std::size_t bit, std::uint64_t &st, std::uint64_t &sx, std::uint64_t &rt)
+  {
+    st |= std::uint64_t{b >= 0x80} << bit;
+    sx |= std::uint64_t{(b == 0xF0) || (b == 0xF7)} << bit;
+    rt |= std::uint64_t{b >= 0xF8} << bit;
+  }
+
+  static void scanBlock(const std::uint8_t *block, std::uint64_t &st, std::uint64_t &sx, std::uint64_t &rt)
+  {
+#if defined(MIDI_SIMD_AVX2)
+    const __m256i f0 = _mm256_set1_epi8(static_cast<char>(0xF0));
+    const __m256i f7 = _mm256_set1_epi8(static_cast<char>(0xF7));
+    const __m256i rtMin = _mm256_set1_epi8(-9); // 0xF8 as signed is -8
+    st = sx = rt = 0;
+    for (std::size_t i = 0; i < 64; i += 32)
+    {
+      const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(block + i));
+      const std::uint64_t s = static_cast<std::uint32_t>(_mm256_movemask_epi8(v));
+      st |= s << i;
+      sx |= std::uint64_t{static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(v, f0), _mm256_cmpeq_epi8(v, f7))))} << i;
+      rt |= (s & static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpgt_epi8(v, rtMin)))) << i;
+    }
+#elif defined(MIDI_SIMD_SSE2)
+    const __m128i f0 = _mm_set1_epi8(static_cast<char>(0xF0));
+    const __m128i f7 = _mm_set1_epi8(static_cast<char>(0xF7));
+    const __m128i rtMin = _mm_set1_epi8(-9); // 0xF8 as signed is -8
+    st = sx = rt = 0;
+    for (std::size_t i = 0; i < 64; i += 16)
+    {
+      const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(block + i));
+      const std::uint64_t s = static_cast<std::uint32_t>(_mm_movemask_epi8(v));
+      st |= s << i;
+      sx |= std::uint64_t{static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, f0), _mm_cmpeq_epi8(v, f7))))} << i;
+      rt |= (s & static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpgt_epi8(v, rtMin)))) << i;
+    }
+#else
+    st = sx = rt = 0;
+    for (std::size_t i = 0; i < 64; ++i)
+      classify(block[i], i, st, sx, rt);
+#endif
+  }
+};
+
+#endif // STATUS_SCANNER_HPP
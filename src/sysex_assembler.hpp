@@ -0,0 +1,314 @@
+#ifndef SYSEX_ASSEMBLER_HPP
+#define SYSEX_ASSEMBLER_HPP
+
+/**
+ * @file sysex_assembler.hpp
+ * @author Etienne SANTOUL github.com/esantoul
+ * @brief MIDI 1.0 SysEx reassembly over a fixed pool of buffers
+ * @version 0.1
+ * @date 2021-02-04
+ *
+ * @copyright BSD 2-Clause License. Copyright (c) 2021, Etienne SANTOUL. All rights reserved.
+ */
+
+#include "midi_parser.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+
+/**
+ * @brief What to do with a SysEx that reaches its stream limit or the global limit
+ */
+enum class SysExPolicy : std::uint8_t
+{
+  Drop,     // discard the whole message
+  Truncate, // keep the bytes held so far, discard the rest & deliver the message flagged as truncated
+  Split,    // deliver the bytes held so far as a segment & keep assembling the rest of the message
+};
+
+enum class SysExSegment : std::uint8_t
+{
+  Complete, // F0 ... F7
+  Start,    // F0 & the first data bytes (Split policy)
+  Continue, // data bytes (Split policy)
+  End,      // last data bytes & F7 (Split policy)
+};
+
+/**
+ * @brief A SysEx (or SysEx segment) delivered by SysExAssembler.
+ * `data` points either into the input buffer (pass-through) or into a pool buffer, and is only valid during the callback
+ */
+struct SysExMessage
+{
+  std::uint16_t stream;
+  SysExSegment segment;
+  bool truncated; // limit reached with the Truncate policy, or message interrupted by a status byte (F7 is appended)
+  bool pooled;    // data was copied into a pool buffer
+  const std::uint8_t *data;
+  std::size_t length;
+
+  /**
+   * @brief Decodes a Complete message through MidiBytes::M1::SystemMessage::SysEx::method, the event payload points into `data`
+   */
+  constexpr ParseInfo decode(MidiEvent *e) const
+  {
+    if (segment != SysExSegment::Complete)
+      return {ParseInfo::E::ERROR_INVALID_CASE};
+    const std::uint8_t *bytes = data;
+    std::size_t len = length;
+    return MidiBytes::M1::SystemMessage::SysEx::method(bytes, len, e);
+  }
+};
+
+/**
+ * @brief Extracts SysEx messages from MIDI 1.0 byte streams delivered in arbitrary chunks.
+ * A SysEx found whole (F0 to F7, no interleaved realtime byte) inside one input chunk is delivered in place.
+ * Otherwise its bytes are copied into a buffer taken from a fixed pool, allocated once at construction
+ * & recycled when the message is delivered. The bytes held by one stream & by all streams together are bounded by
+ * configurable limits, reaching them applies the stream SysExPolicy. Without a free buffer a message is dropped.
+ * @tparam stream_count Number of independent input streams (ports)
+ * @tparam slot_count Number of pool buffers, i.e. SysEx assembled concurrently
+ * @tparam slot_size Size in bytes of each pool buffer (upper bound of the stream limits)
+ */
+template <std::size_t stream_count = 16, std::size_t slot_count = 16, std::size_t slot_size = std::size_t{1} << 16>
+class SysExAssembler
+{
+  static_assert(slot_size >= 2, "A pool buffer must hold at least F0 & F7");
+  static_assert(slot_count < 0xFFFF, "Too many pool buffers");
+
+public:
+  // Bytes of a stream limit, the last byte of a buffer is kept for F7
+  static constexpr std::size_t maxLimit = slot_size - 1;
+
+  SysExAssembler() : mPool{new std::uint8_t[slot_count * slot_size]}
+  {
+    for (std::size_t i = 0; i < slot_count; ++i)
+      mFree[i] = static_cast<std::uint16_t>(slot_count - 1 - i);
+  }
+  SysExAssembler(const SysExAssembler &) = delete;
+  SysExAssembler &operator=(const SysExAssembler &) = delete;
+
+  /**
+   * @brief Sets the byte limit & overflow policy of a stream (default: maxLimit & Truncate)
+   * @param bytes bytes held for one message (or one segment with the Split policy) including F0, clamped to [2, maxLimit]
+   */
+  void setLimit(std::size_t stream, std::size_t bytes, SysExPolicy policy)
+  {
+    mStreams[stream].limit = bytes < 2 ? 2 : (bytes > maxLimit ? maxLimit : bytes);
+    mStreams[stream].policy = policy;
+  }
+
+  /**
+   * @brief Limits the bytes held by all streams together (default: the whole pool)
+   */
+  void setGlobalLimit(std::size_t bytes) { mGlobalLimit = bytes; }
+
+  /**
+   * @brief Consumes a chunk of a stream
+   * @param stream input stream index
+   * @param bytes MIDI 1.0 bytes
+   * @param length number of bytes
+   * @param onBytes callable invoked as onBytes(const std::uint8_t *bytes, std::size_t length) for every run of bytes
+   * outside of SysEx messages, and for realtime bytes interleaved in a SysEx. Runs point into the input
+   * @param onSysEx callable invoked as onSysEx(const SysExMessage &) for every completed SysEx or SysEx segment
+   */
+  template <typename BytesFun_t, typename SysExFun_t>
+  void feed(std::size_t stream, const std::uint8_t *bytes, std::size_t length, BytesFun_t &&onBytes, SysExFun_t &&onSysEx)
+  {
+    Stream &s = mStreams[stream];
+    std::size_t pos = 0;
+    while (pos < length)
+    {
+      if (s.state == State::Idle)
+      {
+        const void *f0 = std::memchr(bytes + pos, 0xF0, length - pos);
+        const std::size_t start = f0 ? std::size_t(static_cast<const std::uint8_t *>(f0) - bytes) : length;
+        if (start > pos)
+          onBytes(bytes + pos, start - pos);
+        if (start == length)
+          return;
+
+        const std::size_t end = dataEnd(bytes, start + 1, length);
+        if (end < length && bytes[end] == 0xF7)
+        {
+          ++mPassedThrough;
+          onSysEx(SysExMessage{static_cast<std::uint16_t>(stream), SysExSegment::Complete, false, false, bytes + start, end + 1 - start});
+          pos = end + 1;
+          continue;
+        }
+        begin(s);
+        pos = start + 1;
+        continue;
+      }
+
+      const std::size_t end = dataEnd(bytes, pos, length);
+      append(s, stream, bytes + pos, end - pos, onSysEx);
+      if (end == length)
+        return;
+
+      const std::uint8_t b = bytes[end];
+      if (b >= 0xF8)
+      {
+        onBytes(bytes + end, 1);
+        pos = end + 1;
+        continue;
+      }
+      finish(s, stream, b == 0xF7, onSysEx);
+      // Any other status byte ends the SysEx & is handled as the start of the next message
+      pos = b == 0xF7 ? end + 1 : end;
+    }
+  }
+
+  /**
+   * @brief Drops the partially assembled SysEx of a stream & recycles its buffer
+   */
+  void reset(std::size_t stream)
+  {
+    release(mStreams[stream]);
+    mStreams[stream].state = State::Idle;
+  }
+
+  void reset()
+  {
+    for (std::size_t i = 0; i < stream_count; ++i)
+      reset(i);
+  }
+
+  // Bytes currently held in pool buffers
+  constexpr std::size_t held() const { return mHeld; }
+  // Pool buffers available
+  constexpr std::size_t available() const { return mFreeCount; }
+  // Messages delivered in place
+  constexpr std::size_t passedThrough() const { return mPassedThrough; }
+  // Messages discarded: Drop policy or no free buffer
+  constexpr std::size_t dropped() const { return mDropped; }
+  // Messages delivered flagged as truncated
+  constexpr std::size_t truncated() const { return mTruncated; }
+
+private:
+  enum class State : std::uint8_t
+  {
+    Idle,
+    Assembling,
+    Truncating, // limit reached with the Truncate policy, data bytes are skipped up to the end
+    Discarding, // message dropped, data bytes are skipped up to the end
+  };
+
+  static constexpr std::uint16_t noSlot = 0xFFFF;
+
+  struct Stream
+  {
+    std::size_t length{};
+    std::size_t limit{maxLimit};
+    std::uint16_t slot{noSlot};
+    State state{};
+    SysExPolicy policy{SysExPolicy::Truncate};
+    bool split{}; // a segment was delivered
+  };
+
+  static std::size_t dataEnd(const std::uint8_t *bytes, std::size_t pos, std::size_t length)
+  {
+    while (pos < length && bytes[pos] < 0x80)
+      ++pos;
+    return pos;
+  }
+
+  std::uint8_t *buffer(const Stream &s) { return mPool.get() + s.slot * slot_size; }
+
+  std::size_t globalRoom() const { return mGlobalLimit > mHeld ? mGlobalLimit - mHeld : 0; }
+
+  void begin(Stream &s)
+  {
+    s.split = false;
+    s.length = 0;
+    if (!mFreeCount || !globalRoom())
+    {
+      s.slot = noSlot;
+      s.state = State::Discarding;
+      ++mDropped;
+      return;
+    }
+    s.slot = mFree[--mFreeCount];
+    s.state = State::Assembling;
+    buffer(s)[0] = 0xF0;
+    s.length = 1;
+    ++mHeld;
+  }
+
+  void release(Stream &s)
+  {
+    if (s.slot == noSlot || s.state == State::Idle || s.state == State::Discarding)
+      return;
+    mHeld -= s.length;
+    mFree[mFreeCount++] = s.slot;
+    s.slot = noSlot;
+    s.length = 0;
+  }
+
+  template <typename SysExFun_t>
+  void append(Stream &s, std::size_t stream, const std::uint8_t *src, std::size_t n, SysExFun_t &onSysEx)
+  {
+    while (n && s.state == State::Assembling)
+    {
+      const std::size_t streamRoom = s.limit - s.length;
+      const std::size_t room = streamRoom < globalRoom() ? streamRoom : globalRoom();
+      const std::size_t k = n < room ? n : room;
+      std::memcpy(buffer(s) + s.length, src, k);
+      s.length += k, mHeld += k;
+      src += k, n -= k;
+      if (!n)
+        return;
+
+      switch (s.policy)
+      {
+      case SysExPolicy::Drop:
+        release(s);
+        s.state = State::Discarding;
+        ++mDropped;
+        return;
+      case SysExPolicy::Truncate:
+        s.state = State::Truncating;
+        return;
+      case SysExPolicy::Split:
+        if (!s.length)
+        {
+          // Nothing left to flush, the other streams hold the global limit: pass the bytes through as a segment
+          onSysEx(SysExMessage{static_cast<std::uint16_t>(stream), SysExSegment::Continue, false, false, src, n});
+          return;
+        }
+        onSysEx(SysExMessage{static_cast<std::uint16_t>(stream), s.split ? SysExSegment::Continue : SysExSegment::Start, false, true, buffer(s), s.length});
+        mHeld -= s.length;
+        s.length = 0;
+        s.split = true;
+        break;
+      }
+    }
+  }
+
+  template <typename SysExFun_t>
+  void finish(Stream &s, std::size_t stream, bool eox, SysExFun_t &onSysEx)
+  {
+    if (s.state != State::Discarding)
+    {
+      const bool cut = !eox || s.state == State::Truncating;
+      mTruncated += cut;
+      buffer(s)[s.length] = 0xF7;
+      onSysEx(SysExMessage{static_cast<std::uint16_t>(stream), s.split ? SysExSegment::End : SysExSegment::Complete, cut, true, buffer(s), s.length + 1});
+      release(s);
+    }
+    s.state = State::Idle;
+  }
+
+  std::unique_ptr<std::uint8_t[]> mPool;
+  std::uint16_t mFree[slot_count]{};
+  std::size_t mFreeCount{slot_count};
+  std::size_t mHeld{};
+  std::size_t mGlobalLimit{slot_count * slot_size};
+  std::size_t mPassedThrough{};
+  std::size_t mDropped{};
+  std::size_t mTruncated{};
+  Stream mStreams[stream_count]{};
+};
+
+#endif // SYSEX_ASSEMBLER_HPP
@@ -0,0 +1,246 @@
+#ifndef SYSEX_CODEC_HPP
+#define SYSEX_CODEC_HPP
+
+/**
+ * @file sysex_codec.hpp
+ * @author Etienne SANTOUL github.com/esantoul
+ * @brief 8-bit data carried in 7-bit SysEx bytes: "8-into-7" packing & nibblized encoding
+ * @version 0.1
+ * @date 2021-02-04
+ *
+ * @copyright BSD 2-Clause License. Copyright (c) 2021, Etienne SANTOUL. All rights reserved.
+ */
+
+#include "midi_parser.hpp"
+#include "payload_view.hpp"
+#include "simd_config.hpp"
+#include <cstddef>
+#include <cstdint>
+
+// Header bit holding the MSB of the first byte of a packed group
+enum class HeaderBits : std::uint8_t
+{
+  FirstHigh, // bit 6 (MIDI-CI Mcoded7)
+  FirstLow,  // bit 0
+};
+
+enum class NibbleOrder : std::uint8_t
+{
+  HighFirst,
+  LowFirst,
+};
+
+/**
+ * @brief Encoders & decoders for the SysEx data bytes, e.g. the bytes left by SysEx::method's StripStatus once the ID &
+ * header bytes are skipped (SysExView::data()).
+ * 8-into-7: each group of up to 7 bytes is sent as a header byte gathering their MSBs followed by their 7 low bits.
+ * Nibblized: each byte is sent as two bytes of 4 bits.
+ * Every routine works into a caller buffer of the output size or in place (out == bytes): encoders run backwards,
+ * decoders forwards, so no unread byte is overwritten. Data bits beyond the format (MSBs, high nibbles) are ignored.
+ */
+struct SysExCodec : NotInstantiable
+{
+  static constexpr std::size_t packedSize(std::size_t length) { return length + (length + 6) / 7; }
+  static constexpr std::size_t unpackedSize(std::size_t length) { return length - (length + 7) / 8; }
+  static constexpr std::size_t nibblizedSize(std::size_t length) { return 2 * length; }
+
+  /**
+   * @brief 8-into-7 encoding, two groups at a time with SSE2
+   * @param out packedSize(length) bytes
+   * @return written bytes
+   */
+  static std::size_t pack(const std::uint8_t *bytes, std::size_t length, std::uint8_t *out, HeaderBits order = HeaderBits::FirstHigh)
+  {
+    const std::size_t groups = (length + 6) / 7;
+    std::size_t simd = 0; // leading groups encoded by pairs, each pair loads one byte past its groups
+#if defined(MIDI_SIMD_SSE2)
+    simd = length ? ((length - 1) / 7) & ~std::size_t{1} : 0;
+#endif
+    for (std::size_t g = groups; g-- > simd;)
+      packGroup(bytes + 7 * g, length - 7 * g < 7 ? length - 7 * g : 7, out + 8 * g, order);
+#if defined(MIDI_SIMD_SSE2)
+    for (std::size_t g = simd; g; g -= 2)
+    {
+      const std::uint8_t *in = bytes + 7 * (g - 2);
+      const __m128i v = _mm_unpacklo_epi64(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(in)),
+                                           _mm_loadl_epi64(reinterpret_cast<const __m128i *>(in + 7)));
+      const std::uint32_t msb = static_cast<std::uint32_t>(_mm_movemask_epi8(v));
+      std::uint32_t h0 = msb & 0x7F;
+      std::uint32_t h1 = msb >> 8 & 0x7F;
+      if (order == HeaderBits::FirstHigh)
+        h0 = reverse7(h0), h1 = reverse7(h1);
+      // Data bytes move up one byte, the 8th byte of each load is shifted out
+      const __m128i d = _mm_slli_epi64(_mm_and_si128(v, _mm_set1_epi8(0x7F)), 8);
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(out + 8 * (g - 2)), _mm_or_si128(d, _mm_set_epi64x(h1, h0)));
+    }
+#endif
+    return packedSize(length);
+  }
+
+  /**
+   * @brief 8-into-7 decoding, two groups at a time with SSE2, four with AVX2
+   * @param out unpackedSize(length) bytes
+   * @return written bytes
+   */
+  static std::size_t unpack(const std::uint8_t *bytes, std::size_t length, std::uint8_t *out, HeaderBits order = HeaderBits::FirstHigh)
+  {
+    std::size_t i = 0;
+    std::size_t n = 0;
+    // Vector stores write up to 2 bytes past their groups, a full group must follow
+#if defined(MIDI_SIMD_AVX2)
+    const __m256i bits = _mm256_set1_epi64x(order == HeaderBits::FirstHigh ? 0x0102040810204000 : 0x4020100804020100);
+    const __m256i broadcast = _mm256_setr_epi8(0, 0, 0, 0, 0, 0, 0, 0, 8, 8, 8, 8, 8, 8, 8, 8,
+                                               0, 0, 0, 0, 0, 0, 0, 0, 8, 8, 8, 8, 8, 8, 8, 8);
+    const __m256i compact = _mm256_setr_epi8(1, 2, 3, 4, 5, 6, 7, 9, 10, 11, 12, 13, 14, 15, -1, -1,
+                                             1, 2, 3, 4, 5, 6, 7, 9, 10, 11, 12, 13, 14, 15, -1, -1);
+    for (; i + 40 <= length; i += 32, n += 28)
+    {
+      const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(bytes + i));
+      const __m256i set = _mm256_cmpeq_epi8(_mm256_and_si256(_mm256_shuffle_epi8(v, broadcast), bits), _mm256_setzero_si256());
+      const __m256i d = _mm256_or_si256(_mm256_and_si256(v, _mm256_set1_epi8(0x7F)), _mm256_andnot_si256(set, _mm256_set1_epi8(static_cast<char>(0x80))));
+      const __m256i r = _mm256_shuffle_epi8(d, compact);
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(out + n), _mm256_castsi256_si128(r));
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(out + n + 14), _mm256_extracti128_si256(r, 1));
+    }
+#elif defined(MIDI_SIMD_SSE2)
+    const __m128i bits = _mm_set1_epi64x(order == HeaderBits::FirstHigh ? 0x0102040810204000 : 0x4020100804020100);
+    for (; i + 24 <= length; i += 16, n += 14)
+    {
+      const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(bytes + i));
+      __m128i h = _mm_and_si128(v, _mm_set1_epi64x(0xFF));
+      h = _mm_or_si128(h, _mm_slli_epi64(h, 8));
+      h = _mm_or_si128(h, _mm_slli_epi64(h, 16));
+      h = _mm_or_si128(h, _mm_slli_epi64(h, 32));
+      const __m128i set = _mm_cmpeq_epi8(_mm_and_si128(h, bits), _mm_setzero_si128());
+      const __m128i d = _mm_or_si128(_mm_and_si128(v, _mm_set1_epi8(0x7F)), _mm_andnot_si128(set, _mm_set1_epi8(static_cast<char>(0x80))));
+      const __m128i r = _mm_srli_epi64(d, 8);
+      _mm_storel_epi64(reinterpret_cast<__m128i *>(out + n), r);
+      _mm_storel_epi64(reinterpret_cast<__m128i *>(out + n + 7), _mm_srli_si128(r, 8));
+    }
+#endif
+    for (; i < length; i += 8)
+    {
+      const std::size_t m = length - i < 8 ? length - i : 8;
+      unpackGroup(bytes + i, m, out + n, order);
+      n += m - 1;
+    }
+    return n;
+  }
+
+  /**
+   * @brief Nibblized encoding, 16 bytes at a time with SSE2 (AVX2 gains nothing, the cross lane interleave costs as much as it saves)
+   * @param out nibblizedSize(length) bytes
+   * @return written bytes
+   */
+  static std::size_t nibblize(const std::uint8_t *bytes, std::size_t length, std::uint8_t *out, NibbleOrder order = NibbleOrder::HighFirst)
+  {
+    std::size_t simd = 0; // leading bytes encoded by blocks of 16
+#if defined(MIDI_SIMD_SSE2)
+    simd = length & ~std::size_t{15};
+#endif
+    for (std::size_t i = length; i-- > simd;)
+    {
+      const std::uint8_t b = bytes[i];
+      out[2 * i] = order == NibbleOrder::HighFirst ? b >> 4 : b & 0x0F;
+      out[2 * i + 1] = order == NibbleOrder::HighFirst ? b & 0x0F : b >> 4;
+    }
+#if defined(MIDI_SIMD_SSE2)
+    for (std::size_t i = simd; i; i -= 16)
+    {
+      const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(bytes + i - 16));
+      const __m128i lo = _mm_and_si128(v, _mm_set1_epi8(0x0F));
+      const __m128i hi = _mm_and_si128(_mm_srli_epi16(v, 4), _mm_set1_epi8(0x0F));
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(out + 2 * i - 32), order == NibbleOrder::HighFirst ? _mm_unpacklo_epi8(hi, lo) : _mm_unpacklo_epi8(lo, hi));
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(out + 2 * i - 16), order == NibbleOrder::HighFirst ? _mm_unpackhi_epi8(hi, lo) : _mm_unpackhi_epi8(lo, hi));
+    }
+#endif
+    return nibblizedSize(length);
+  }
+
+  /**
+   * @brief Nibblized decoding, 16 bytes at a time with SSE2, 32 with AVX2. A trailing odd byte is ignored
+   * @param out length / 2 bytes
+   * @return written bytes
+   */
+  static std::size_t denibblize(const std::uint8_t *bytes, std::size_t length, std::uint8_t *out, NibbleOrder order = NibbleOrder::HighFirst)
+  {
+    const std::size_t n = length / 2;
+    std::size_t i = 0;
+#if defined(MIDI_SIMD_AVX2)
+    for (; i + 32 <= n; i += 32)
+    {
+      const __m256i a = join(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(bytes + 2 * i)), order);
+      const __m256i b = join(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(bytes + 2 * i + 32)), order);
+      _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i), _mm256_permute4x64_epi64(_mm256_packus_epi16(a, b), 0xD8));
+    }
+#elif defined(MIDI_SIMD_SSE2)
+    for (; i + 16 <= n; i += 16)
+    {
+      const __m128i a = join(_mm_loadu_si128(reinterpret_cast<const __m128i *>(bytes + 2 * i)), order);
+      const __m128i b = join(_mm_loadu_si128(reinterpret_cast<const __m128i *>(bytes + 2 * i + 16)), order);
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), _mm_packus_epi16(a, b));
+    }
+#endif
+    for (; i < n; ++i)
+    {
+      const std::uint8_t first = bytes[2 * i] & 0x0F;
+      const std::uint8_t second = bytes[2 * i + 1] & 0x0F;
+      out[i] = static_cast<std::uint8_t>(order == NibbleOrder::HighFirst ? first << 4 | second : second << 4 | first);
+    }
+    return n;
+  }
+
+  // Decoders over a SysEx payload view
+  static std::size_t unpack(const PayloadView &p, std::uint8_t *out, HeaderBits order = HeaderBits::FirstHigh) { return unpack(p.data(), p.size(), out, order); }
+  static std::size_t denibblize(const PayloadView &p, std::uint8_t *out, NibbleOrder order = NibbleOrder::HighFirst) { return denibblize(p.data(), p.size(), out, order); }
+
+private:
+  // Reverses the 7 low bits
+  static constexpr std::uint32_t reverse7(std::uint32_t m) { return static_cast<std::uint32_t>(((m * 0x0202020202ULL & 0x010884422010ULL) % 1023) >> 1); }
+
+  static constexpr std::uint8_t headerBit(std::size_t i, HeaderBits order) { return static_cast<std::uint8_t>(order == HeaderBits::FirstHigh ? 6 - i : i); }
+
+  // Up to 7 bytes, copied first as in place packing writes over the following ones
+  static constexpr void packGroup(const std::uint8_t *bytes, std::size_t n, std::uint8_t *out, HeaderBits order)
+  {
+    std::uint8_t d[7]{};
+    std::uint8_t h = 0;
+    for (std::size_t i = 0; i < n; ++i)
+    {
+      d[i] = bytes[i];
+      h = static_cast<std::uint8_t>(h | (d[i] >> 7) << headerBit(i, order));
+    }
+    out[0] = h;
+    for (std::size_t i = 0; i < n; ++i)
+      out[1 + i] = d[i] & 0x7F;
+  }
+
+  // A header & up to 7 bytes
+  static constexpr void unpackGroup(const std::uint8_t *bytes, std::size_t m, std::uint8_t *out, HeaderBits order)
+  {
+    const std::uint8_t h = bytes[0];
+    for (std::size_t i = 0; i + 1 < m; ++i)
+      out[i] = static_cast<std::uint8_t>((bytes[1 + i] & 0x7F) | (h >> headerBit(i, order) & 1) << 7);
+  }
+
+  // 16-bit lanes of two nibbles to their byte value
+#if defined(MIDI_SIMD_AVX2)
+  static __m256i join(__m256i x, NibbleOrder order)
+  {
+    const __m256i f = _mm256_set1_epi16(0x0F);
+    return order == NibbleOrder::HighFirst
+             ? _mm256_or_si256(_mm256_slli_epi16(_mm256_and_si256(x, f), 4), _mm256_and_si256(_mm256_srli_epi16(x, 8), f))
+             : _mm256_or_si256(_mm256_and_si256(x, f), _mm256_and_si256(_mm256_srli_epi16(x, 4), _mm256_set1_epi16(0xF0)));
+  }
+#elif defined(MIDI_SIMD_SSE2)
+  static __m128i join(__m128i x, NibbleOrder order)
+  {
+    const __m128i f = _mm_set1_epi16(0x0F);
+    return order == NibbleOrder::HighFirst
+             ? _mm_or_si128(_mm_slli_epi16(_mm_and_si128(x, f), 4), _mm_and_si128(_mm_srli_epi16(x, 8), f))
+             : _mm_or_si128(_mm_and_si128(x, f), _mm_and_si128(_mm_srli_epi16(x, 4), _mm_set1_epi16(0xF0)));
+  }
+#endif
+};
+
+#endif // SYSEX_CODEC_HPP
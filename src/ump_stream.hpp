@@ -0,0 +1,278 @@
+#ifndef UMP_STREAM_HPP
+#define UMP_STREAM_HPP
+
+/**
+ * @file ump_stream.hpp
+ * @author Etienne SANTOUL github.com/esantoul
+ * @brief Universal MIDI Packet stream reader: packet framing & SysEx7/SysEx8 reassembly
+ * @version 0.1
+ * @date 2021-02-04
+ *
+ * @copyright BSD 2-Clause License. Copyright (c) 2021, Etienne SANTOUL. All rights reserved.
+ */
+
+#include "midi_parser.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+// UMP packet framing helpers
+struct UmpFraming : NotInstantiable
+{
+  /**
+   * @brief Packet size in 32-bit words indexed by message type (first nibble of the first word).
+   * Known message types take their size from the MidiBytes::M2 insight values, reserved ones from the UMP specification.
+   */
+  static constexpr std::uint8_t words[16] = {
+    MidiBytes::M2::Utility::insight().value() / 4,
+    MidiBytes::M2::System::insight().value() / 4,
+    MidiBytes::M2::Midi1Channel::insight().value() / 4,
+    MidiBytes::M2::Data64Bits::insight().value() / 4,
+    MidiBytes::M2::Midi2Channel::insight().value() / 4,
+    MidiBytes::M2::Data128Bits::insight().value() / 4,
+    1, 1, 2, 2, 2, 3, 3, 4, 4, 4};
+
+  static constexpr std::uint8_t messageType(std::uint32_t word) { return word >> 28; }
+  static constexpr std::uint8_t group(std::uint32_t word) { return (word >> 24) & 0x0F; }
+  static constexpr std::size_t packetWords(std::uint32_t word) { return words[messageType(word)]; }
+
+  /**
+   * @brief Unpacks UMP words into the big-endian byte layout expected by MidiBytes::M2
+   * @param words first word of the packet
+   * @param count number of words to unpack
+   * @param bytes output buffer of at least 4 * count bytes
+   */
+  static constexpr void toBytes(const std::uint32_t *words, std::size_t count, std::uint8_t *bytes)
+  {
+    for (std::size_t i = 0; i < count; ++i)
+    {
+      bytes[4 * i + 0] = words[i] >> 24;
+      bytes[4 * i + 1] = words[i] >> 16;
+      bytes[4 * i + 2] = words[i] >> 8;
+      bytes[4 * i + 3] = words[i];
+    }
+  }
+};
+
+/**
+ * @brief A reassembled SysEx payload as delivered by UmpStream
+ */
+struct UmpSysEx
+{
+  std::uint8_t group;
+  std::uint8_t streamId; // always 0 for SysEx7
+  bool sysex8;
+  bool truncated; // the payload exceeded the reassembly buffer and was cut
+  const std::uint8_t *data;
+  std::size_t length;
+};
+
+/**
+ * @brief Frames a stream of UMP words into packets and reassembles multi-packet SysEx7 (message type 0x3) and SysEx8 (message type 0x5) data.
+ * SysEx7 is reassembled per group, SysEx8 per group and stream ID. All storage is bounded and owned by the object.
+ * @tparam SysEx7_sz Capacity in bytes of each SysEx7 reassembly buffer (one buffer per group)
+ * @tparam SysEx8_sz Capacity in bytes of each SysEx8 reassembly buffer
+ * @tparam SysEx8_slots Maximum number of SysEx8 (group, stream ID) pairs reassembled concurrently
+ */
+template <std::size_t SysEx7_sz = 256, std::size_t SysEx8_sz = 256, std::size_t SysEx8_slots = 8>
+class UmpStream
+{
+public:
+  constexpr UmpStream() = default;
+
+  /**
+   * @brief Consumes as many complete packets as available
+   * @param words packed 32-bit UMP words
+   * @param count number of words available
+   * @param onPacket callable invoked as onPacket(const std::uint32_t *packet, std::size_t words) for every packet that is not SysEx7/SysEx8 data
+   * @param onSysEx callable invoked as onSysEx(const UmpSysEx &) once per completed SysEx7/SysEx8 payload
+   * @return the number of words consumed. Trailing words of an incomplete packet are left for the next call
+   */
+  template <typename PacketFun_t, typename SysExFun_t>
+  constexpr std::size_t feed(const std::uint32_t *words, std::size_t count, PacketFun_t &&onPacket, SysExFun_t &&onSysEx)
+  {
+    std::size_t pos = 0;
+    while (pos < count)
+    {
+      const std::size_t sz = UmpFraming::packetWords(words[pos]);
+      if (pos + sz > count)
+        break;
+
+      switch (UmpFraming::messageType(words[pos]))
+      {
+      case MidiBytes::M2::Data64Bits::value >> 4:
+        if (!sysex7(words + pos, onSysEx))
+          onPacket(words + pos, sz);
+        break;
+      case MidiBytes::M2::Data128Bits::value >> 4:
+        if (!sysex8(words + pos, onSysEx))
+          onPacket(words + pos, sz);
+        break;
+      default:
+        onPacket(words + pos, sz);
+        break;
+      }
+      pos += sz;
+    }
+    return pos;
+  }
+
+  /**
+   * @brief Drops every partially reassembled SysEx
+   */
+  constexpr void reset()
+  {
+    for (auto &a : mSysEx7)
+      a.active = false;
+    for (auto &a : mSysEx8)
+      a.active = false;
+  }
+
+  /**
+   * @brief Number of SysEx8 start packets dropped because all reassembly slots were in use
+   */
+  constexpr std::size_t droppedSysEx8() const { return mDropped; }
+
+private:
+  enum Status : std::uint8_t
+  {
+    Complete = 0x0,
+    Start = 0x1,
+    Continue = 0x2,
+    End = 0x3
+  };
+
+  template <std::size_t sz>
+  struct Assembly
+  {
+    constexpr void begin(std::uint8_t grp, std::uint8_t sid)
+    {
+      active = true;
+      truncated = false;
+      group = grp;
+      streamId = sid;
+      length = 0;
+    }
+
+    constexpr void append(const std::uint8_t *src, std::size_t n)
+    {
+      if (length + n > sz)
+      {
+        truncated = true;
+        n = sz - length;
+      }
+      for (std::size_t i = 0; i < n; ++i)
+        data[length++] = src[i];
+    }
+
+    bool active{};
+    bool truncated{};
+    std::uint8_t group{};
+    std::uint8_t streamId{};
+    std::size_t length{};
+    std::uint8_t data[sz]{};
+  };
+
+  // @return false if the packet is not SysEx data and must be forwarded as a plain packet
+  template <typename SysExFun_t>
+  constexpr bool sysex7(const std::uint32_t *packet, SysExFun_t &onSysEx)
+  {
+    std::uint8_t bytes[8]{};
+    UmpFraming::toBytes(packet, 2, bytes);
+    const std::uint8_t status = bytes[1] >> 4;
+    if (status > End)
+      return false;
+
+    const std::uint8_t grp = bytes[0] & 0x0F;
+    const std::size_t n = std::min<std::size_t>(bytes[1] & 0x0F, 6);
+    const std::uint8_t *payload = bytes + 2;
+
+    if (status == Complete)
+    {
+      onSysEx(UmpSysEx{grp, 0, false, false, payload, n});
+      return true;
+    }
+
+    auto &a = mSysEx7[grp];
+    if (status == Start)
+      a.begin(grp, 0);
+    else if (!a.active)
+      return true; // continuation of a SysEx whose start was never seen
+
+    a.append(payload, n);
+    if (status == End)
+    {
+      a.active = false;
+      onSysEx(UmpSysEx{grp, 0, false, a.truncated, a.data, a.length});
+    }
+    return true;
+  }
+
+  template <typename SysExFun_t>
+  constexpr bool sysex8(const std::uint32_t *packet, SysExFun_t &onSysEx)
+  {
+    std::uint8_t bytes[16]{};
+    UmpFraming::toBytes(packet, 4, bytes);
+    const std::uint8_t status = bytes[1] >> 4;
+    if (status > End)
+      return false;
+
+    const std::uint8_t grp = bytes[0] & 0x0F;
+    const std::uint8_t sid = bytes[2];
+    // The byte count includes the stream ID
+    const std::size_t n = std::min<std::size_t>(bytes[1] & 0x0F, 14);
+    const std::size_t payloadLength = n ? n - 1 : 0;
+    const std::uint8_t *payload = bytes + 3;
+
+    if (status == Complete)
+    {
+      onSysEx(UmpSysEx{grp, sid, true, false, payload, payloadLength});
+      return true;
+    }
+
+    auto *a = find(grp, sid);
+    if (status == Start)
+    {
+      if (!a)
+        a = find();
+      if (!a)
+      {
+        ++mDropped;
+        return true;
+      }
+      a->begin(grp, sid);
+    }
+    else if (!a)
+      return true;
+
+    a->append(payload, payloadLength);
+    if (status == End)
+    {
+      a->active = false;
+      onSysEx(UmpSysEx{grp, sid, true, a->truncated, a->data, a->length});
+    }
+    return true;
+  }
+
+  constexpr Assembly<SysEx8_sz> *find(std::uint8_t grp, std::uint8_t sid)
+  {
+    for (auto &a : mSysEx8)
+      if (a.active && a.group == grp && a.streamId == sid)
+        return &a;
+    return nullptr;
+  }
+
+  constexpr Assembly<SysEx8_sz> *find()
+  {
+    for (auto &a : mSysEx8)
+      if (!a.active)
+        return &a;
+    return nullptr;
+  }
+
+  Assembly<SysEx7_sz> mSysEx7[16]{};
+  Assembly<SysEx8_sz> mSysEx8[SysEx8_slots]{};
+  std::size_t mDropped{};
+};
+
+#endif // UMP_STREAM_HPP
@@ -0,0 +1,81 @@
+#ifndef UMP_TRANSLATE_HPP
+#define UMP_TRANSLATE_HPP
+
+/**
+ * @file ump_translate.hpp
+ * @author Etienne SANTOUL github.com/esantoul
+ * @brief MIDI 1.0 to Universal MIDI Packet translation
+ * @version 0.1
+ * @date 2021-02-04
+ *
+ * @copyright BSD 2-Clause License. Copyright (c) 2021, Etienne SANTOUL. All rights reserved.
+ */
+
+#include "midi_encode.hpp"
+#include "midi_parser.hpp"
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Translates decoded MIDI 1.0 events into UMP words:
+ * channel voice messages into MIDI 1.0 Channel Voice packets (message type 0x2),
+ * system common & realtime messages into System packets (message type 0x1)
+ * and SysEx into Data64Bits SysEx7 packet sequences (message type 0x3).
+ * @tparam ports Number of input ports, each port is mapped to a UMP group (group 0 by default)
+ */
+template <std::size_t ports = 16>
+class UmpTranslator
+{
+public:
+  constexpr UmpTranslator() = default;
+
+  constexpr void setGroup(std::size_t port, std::uint8_t group) { mGroups[port] = group & 0x0F; }
+  constexpr std::uint8_t group(std::size_t port) const { return mGroups[port]; }
+
+  /**
+   * @brief Number of UMP words produced for an event, 0 if the event is not a translatable MIDI 1.0 message
+   */
+  static constexpr std::size_t size(const MidiEvent &e) { return e.protocol == 1 ? MidiEncode::umpSize(e) : 0; }
+
+  /**
+   * @brief Translates one event
+   * @param e decoded MIDI 1.0 event
+   * @param group target UMP group
+   * @param words output buffer
+   * @param capacity output buffer capacity in words
+   * @return the number of words written, 0 if the event is not translatable or does not fit
+   */
+  static constexpr std::size_t translate(const MidiEvent &e, std::uint8_t group, std::uint32_t *words, std::size_t capacity)
+  {
+    const std::size_t sz = size(e);
+    if (!sz || sz > capacity)
+      return 0;
+    MidiEvent grouped = e;
+    grouped.group = group;
+    return MidiEncode::ump(grouped, words);
+  }
+
+  /**
+   * @brief Translates a batch of events received on a port into the port's group
+   * @return consumed events & produced words. Untranslatable events are consumed without output,
+   * translation stops before the first event that does not fit
+   */
+  constexpr BatchInfo translate(const MidiEvent *events, std::size_t count, std::size_t port, std::uint32_t *words, std::size_t capacity) const
+  {
+    const std::uint8_t grp = mGroups[port];
+    std::size_t i = 0;
+    std::size_t n = 0;
+    for (; i < count; ++i)
+    {
+      if (size(events[i]) > capacity - n)
+        break;
+      n += translate(events[i], grp, words + n, capacity - n);
+    }
+    return {i, n};
+  }
+
+private:
+  std::uint8_t mGroups[ports]{};
+};
+
+#endif // UMP_TRANSLATE_HPP
@@ -0,0 +1,241 @@
+/**
+ * @file encode_roundtrip.cpp
+ * @author Etienne SANTOUL github.com/esantoul
+ * @brief Property test: random events encoded then decoded come back as the source events, restricted to the fields the
+ * wire carries. MIDI 1.0 events go through a MidiEncoder stream (running status on) & MidiBytes::InterpretBatch, UMP
+ * events (MIDI 1.0 & MIDI 2.0 protocols) through a UmpEncoder stream & MidiBytes::InterpretWords
+ * @version 0.1
+ * @date 2021-02-04
+ *
+ * @copyright BSD 2-Clause License. Copyright (c) 2021, Etienne SANTOUL. All rights reserved.
+ */
+
+#define MIDI_PARSER_ENABLE_MIDI2
+
+#include "midi_batch.hpp"
+#include "midi_encode.hpp"
+#include "test.hpp"
+#include "../src/midi_parser.cpp.template"
+#include <cstdint>
+#include <vector>
+
+namespace
+{
+  constexpr EventType kTypes[] = {
+      EventType::NoteOff, EventType::NoteOn, EventType::PolyPressure, EventType::ControlChange, EventType::ProgramChange,
+      EventType::ChannelPressure, EventType::PitchBend, EventType::MTC, EventType::SongPos, EventType::SongSel,
+      EventType::TuneRequest, EventType::TimingClock, EventType::Start, EventType::Stop, EventType::ActiveSensing,
+      EventType::SysEx, EventType::UniversalNonRT, EventType::UniversalRT};
+
+  // UMP only types, MIDI 2.0 channel voice types come from kTypes
+  constexpr EventType kUmpTypes[] = {
+      EventType::NOOP, EventType::JRClock, EventType::JRTimestamp, EventType::DeltaClockstampTPQ, EventType::DeltaClockstamp,
+      EventType::RegistPerNoteCtrl, EventType::AssignPerNoteCtrl, EventType::RegistCtrl, EventType::AssignCtrl,
+      EventType::RelativeRegistCtrl, EventType::RelativeAssignCtrl, EventType::PerNotePitchBend, EventType::PerNoteManagement,
+      EventType::SysEx7, EventType::SysEx8, EventType::MixedDataSetHeader, EventType::MixedDataSetPayload};
+
+  bool isSysEx(EventType t) { return t == EventType::SysEx || t == EventType::UniversalNonRT || t == EventType::UniversalRT; }
+
+  // Random protocol 1 event, channel voice types weighted up & few channels so that running status kicks in. Every field
+  // is random, including those the message does not carry. SysEx payloads are written to `sysex`, which must outlive the event
+  MidiEvent randomEvent(test::Rng &rng, std::vector<std::uint8_t> &sysex)
+  {
+    MidiEvent e{};
+    e.protocol = 1;
+    const std::uint32_t pick = rng() % 32;
+    e.type = pick < 14 ? kTypes[pick % 7] : kTypes[pick % (sizeof kTypes / sizeof *kTypes)];
+    e.group = rng() % 16;
+    e.channel = rng() % 2;
+    e.data1 = static_cast<std::uint8_t>(rng());
+    e.data2 = static_cast<std::uint8_t>(rng());
+    e.data16 = static_cast<std::uint16_t>(rng());
+    e.value = rng();
+    if (isSysEx(e.type))
+    {
+      sysex.resize(1 + rng() % 24);
+      for (auto &b : sysex)
+        b = rng() & 0x7F;
+      if (e.type != EventType::SysEx)
+        sysex[0] = static_cast<std::uint8_t>(e.type);
+      else if (sysex[0] >= 0x7E)
+        sysex[0] = 0x7D;
+      // Universal SysEx need a device ID & a sub-ID#1 known to both tables (sample dumps, 1 to 3, have fixed sizes)
+      if (e.type != EventType::SysEx && sysex.size() < 3)
+        sysex.resize(3);
+      if (e.type != EventType::SysEx)
+        sysex[2] = static_cast<std::uint8_t>(0x04 + rng() % 5);
+      e.payload = sysex.data();
+      e.length = static_cast<std::uint32_t>(sysex.size());
+    }
+    return e;
+  }
+
+  // The source event restricted to what a MIDI 1.0 message carries, in the field layout of the decoders
+  MidiEvent m1Wire(const MidiEvent &e)
+  {
+    MidiEvent w{e.type, 1};
+    const std::uint8_t t = static_cast<std::uint8_t>(e.type);
+    if (e.type >= EventType::NoteOff && e.type < EventType::SysEx)
+      w.channel = e.channel & 0x0F;
+    if (e.type == EventType::PitchBend || e.type == EventType::SongPos)
+      w.value = e.value & 0x3FFF;
+    else if (e.type == EventType::ChannelPressure)
+      w.value = e.value & 0x7F;
+    else if (e.type == EventType::ProgramChange || e.type == EventType::MTC || e.type == EventType::SongSel)
+      w.data1 = e.data1 & 0x7F;
+    else if (t >= 0x80 && t < 0xF0)
+      w.data1 = e.data1 & 0x7F, w.value = e.value & 0x7F;
+    else if (isSysEx(e.type))
+    {
+      // DecodeSysEx keeps the first byte, DecodeUniversal the device ID, sub-ID#1 & sub-ID#2
+      w.data1 = e.payload[e.type == EventType::SysEx ? 0 : 1];
+      if (e.type != EventType::SysEx)
+        w.data2 = e.payload[2], w.data16 = e.length > 3 ? e.payload[3] : 0;
+      w.payload = e.payload, w.length = e.length;
+    }
+    return w;
+  }
+
+  // Random UMP event: MIDI 1.0 channel voice & system packets (protocol 1), MIDI 2.0 channel voice, utility & data packets
+  MidiEvent randomUmpEvent(test::Rng &rng, std::vector<std::uint8_t> &payload)
+  {
+    MidiEvent e{};
+    const std::uint32_t pick = rng() % 4;
+    e.protocol = pick ? 2 : 1;
+    do
+      e.type = pick < 2 ? kTypes[rng() % 15] : pick == 2 ? kTypes[rng() % 7] : kUmpTypes[rng() % (sizeof kUmpTypes / sizeof *kUmpTypes)];
+    while (e.protocol == 2 && e.type >= EventType::SysEx);
+    e.group = rng() % 16;
+    e.channel = rng() % 16;
+    e.data1 = static_cast<std::uint8_t>(rng());
+    e.data2 = static_cast<std::uint8_t>(rng());
+    e.data16 = static_cast<std::uint16_t>(rng());
+    e.value = rng();
+    if (e.type == EventType::SysEx7 || e.type == EventType::SysEx8 || e.type == EventType::MixedDataSetHeader || e.type == EventType::MixedDataSetPayload)
+    {
+      // Status of the data packet: single packet, start, continue or end
+      e.data2 %= 4;
+      payload.resize(rng() % 16);
+      for (auto &b : payload)
+        b = static_cast<std::uint8_t>(rng());
+      e.payload = payload.data();
+      e.length = static_cast<std::uint32_t>(payload.size());
+    }
+    return e;
+  }
+
+  // The source event restricted to what its packet carries. Payloads are not compared, InterpretWords clears them
+  MidiEvent umpWire(const MidiEvent &e)
+  {
+    if (e.protocol == 1)
+    {
+      MidiEvent w = m1Wire(e);
+      w.group = e.group & 0x0F;
+      return w;
+    }
+    MidiEvent w{e.type, 2, std::uint8_t(e.group & 0x0F)};
+    switch (e.type)
+    {
+    case EventType::NOOP:
+      break;
+    case EventType::DeltaClockstamp:
+      w.value = e.value & 0xFFFFF;
+      break;
+    case EventType::JRClock:
+    case EventType::JRTimestamp:
+    case EventType::DeltaClockstampTPQ:
+      w.value = e.value & 0xFFFF;
+      break;
+    case EventType::SysEx7:
+      w.data2 = e.data2, w.length = e.length < 6 ? e.length : 6;
+      break;
+    case EventType::SysEx8:
+      w.data1 = e.data1, w.data2 = e.data2, w.length = e.length < 13 ? e.length : 13;
+      break;
+    case EventType::MixedDataSetHeader:
+    case EventType::MixedDataSetPayload:
+      w.data1 = e.data1 & 0x0F, w.length = 14;
+      break;
+    case EventType::NoteOff:
+    case EventType::NoteOn:
+      w.channel = e.channel & 0x0F, w.data1 = e.data1, w.data2 = e.data2, w.value = e.value & 0xFFFF, w.data16 = e.data16;
+      break;
+    case EventType::ProgramChange:
+      w.channel = e.channel & 0x0F, w.data1 = e.data1 & 0x7F, w.data2 = e.data2, w.data16 = e.data16 & 0x3FFF;
+      break;
+    default:
+      w.channel = e.channel & 0x0F, w.data1 = e.data1, w.data2 = e.data2, w.value = e.value;
+      break;
+    }
+    return w;
+  }
+
+  void m1RoundTrip(test::Rng &rng)
+  {
+    for (int round = 0; round < 2000; ++round)
+    {
+      const std::size_t count = 1 + rng() % 64;
+      std::vector<std::vector<std::uint8_t>> sysex(count);
+      std::vector<MidiEvent> expected(count);
+      std::vector<std::uint8_t> stream(count * 32);
+      MidiEncoder encoder{stream.data(), stream.size(), true};
+      for (std::size_t i = 0; i < count; ++i)
+      {
+        const MidiEvent e = randomEvent(rng, sysex[i]);
+        expected[i] = m1Wire(e);
+        CHECK(encoder.append(e));
+      }
+
+      // Whole stream, then the same stream fed in two arbitrary chunks with the running status carried over. SysEx
+      // payloads point into the stream, compared by content
+      std::vector<MidiEvent> events(count);
+      const BatchInfo r = MidiBytes::InterpretBatch(stream.data(), encoder.size(), events.data(), count);
+      CHECK(r.consumed == encoder.size());
+      CHECK(r.produced == count);
+      for (std::size_t i = 0; i < r.produced && i < count; ++i)
+        CHECK(test::same(events[i], expected[i]));
+
+      std::uint8_t running = 0;
+      const std::size_t cut = rng() % (encoder.size() + 1);
+      const BatchInfo a = MidiBytes::InterpretBatch(stream.data(), cut, events.data(), count, running);
+      const BatchInfo b = MidiBytes::InterpretBatch(stream.data() + a.consumed, encoder.size() - a.consumed, events.data() + a.produced, count - a.produced, running);
+      CHECK(a.consumed + b.consumed == encoder.size());
+      CHECK(a.produced + b.produced == count);
+      for (std::size_t i = 0; i < a.produced + b.produced && i < count; ++i)
+        CHECK(test::same(events[i], expected[i]));
+    }
+  }
+
+  void umpRoundTrip(test::Rng &rng)
+  {
+    for (int round = 0; round < 2000; ++round)
+    {
+      const std::size_t count = 1 + rng() % 64;
+      std::vector<std::vector<std::uint8_t>> payload(count);
+      std::vector<MidiEvent> expected(count);
+      std::vector<std::uint32_t> stream(count * 4);
+      UmpEncoder encoder{stream.data(), stream.size()};
+      for (std::size_t i = 0; i < count; ++i)
+      {
+        const MidiEvent e = randomUmpEvent(rng, payload[i]);
+        expected[i] = umpWire(e);
+        CHECK(encoder.append(e));
+      }
+
+      std::vector<MidiEvent> events(count);
+      const BatchInfo r = MidiBytes::InterpretWords(stream.data(), encoder.size(), events.data(), count);
+      CHECK(r.consumed == encoder.size());
+      CHECK(r.produced == count);
+      for (std::size_t i = 0; i < r.produced && i < count; ++i)
+        CHECK(test::same(events[i], expected[i]));
+    }
+  }
+} // namespace
+
+int main()
+{
+  test::Rng rng{0x2021};
+  m1RoundTrip(rng);
+  umpRoundTrip(rng);
+  return test::report("encode_roundtrip");
+}
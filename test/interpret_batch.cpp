@@ -0,0 +1,154 @@
+/**
+ * @file interpret_batch.cpp
+ * @author Etienne SANTOUL github.com/esantoul
+ * @brief MidiBytes::InterpretBatch against M1Framing units interpreted one by one, and MidiBytes::InterpretWords against
+ * packets interpreted one by one with MidiBytes::M2::method, over random streams cut anywhere & random capacities
+ * @version 0.1
+ * @date 2021-02-04
+ *
+ * @copyright BSD 2-Clause License. Copyright (c) 2021, Etienne SANTOUL. All rights reserved.
+ */
+
+#define MIDI_PARSER_ENABLE_MIDI2
+
+#include "midi_batch.hpp"
+#include "test.hpp"
+#include "../src/midi_parser.cpp.template"
+#include <cstdint>
+#include <vector>
+
+namespace
+{
+  // Channel messages with & without status byte, system common, realtime bytes anywhere, SysEx, undefined status bytes
+  // & data bytes out of place
+  std::vector<std::uint8_t> randomBytes(test::Rng &rng, std::size_t length)
+  {
+    constexpr std::uint8_t system[] = {0xF0, 0xF1, 0xF2, 0xF3, 0xF4, 0xF5, 0xF6, 0xF7, 0xF8, 0xF9, 0xFA, 0xFD, 0xFE, 0xFF};
+    std::vector<std::uint8_t> bytes(length);
+    for (auto &b : bytes)
+    {
+      const std::uint32_t pick = rng() % 16;
+      b = pick < 10 ? rng() & 0x7F : pick < 14 ? 0x80 | (rng() & 0x6F) : system[rng() % sizeof system];
+    }
+    return bytes;
+  }
+
+  // The framing path of InterpretBatch, unit by unit
+  BatchInfo interpretUnits(const std::uint8_t *bytes, std::size_t length, MidiEvent *events, std::size_t capacity, std::uint8_t &running)
+  {
+    std::size_t pos = 0;
+    std::size_t n = 0;
+    while (pos < length)
+    {
+      const std::uint8_t prev = running;
+      const M1Framing::Unit u = M1Framing::next(bytes, length, pos, running);
+      const bool message = u.kind == M1Framing::Unit::Kind::Message || u.kind == M1Framing::Unit::Kind::SysEx;
+      if (u.kind == M1Framing::Unit::Kind::Incomplete || n + M1Framing::realtime(bytes, pos, u.end) + message > capacity)
+      {
+        running = prev;
+        break;
+      }
+      for (std::size_t i = pos; i < u.end; ++i)
+        if (bytes[i] >= 0xF8)
+          n += MidiBytes::Interpret(bytes + i, 1, events + n).status() == ParseInfo::E::SUCCESS;
+      if (u.kind == M1Framing::Unit::Kind::Message)
+        n += MidiBytes::Interpret(u.message, u.length, events + n).status() == ParseInfo::E::SUCCESS;
+      else if (u.kind == M1Framing::Unit::Kind::SysEx)
+        n += MidiBytes::Interpret(bytes + pos, u.end - pos, events + n).status() == ParseInfo::E::SUCCESS;
+      pos = u.end;
+    }
+    return {pos, n};
+  }
+
+  void interpretBatch(test::Rng &rng)
+  {
+    for (int round = 0; round < 5000; ++round)
+    {
+      const std::vector<std::uint8_t> bytes = randomBytes(rng, rng() % 200);
+      const std::size_t capacity = rng() % 4 ? bytes.size() : rng() % (bytes.size() + 1);
+      std::vector<MidiEvent> expected(capacity + 1), events(capacity + 1);
+
+      // Fed in chunks, the running status carried over
+      std::uint8_t refRunning = rng() % 2 ? 0x90 : 0;
+      std::uint8_t running = refRunning;
+      std::size_t refPos = 0, refN = 0, pos = 0, n = 0;
+      for (int chunk = 0; chunk < 64 && refPos < bytes.size(); ++chunk)
+      {
+        const std::size_t end = refPos + 1 + rng() % (bytes.size() - refPos);
+        const BatchInfo ref = interpretUnits(bytes.data() + refPos, end - refPos, expected.data() + refN, capacity - refN, refRunning);
+        const BatchInfo r = MidiBytes::InterpretBatch(bytes.data() + pos, end - pos, events.data() + n, capacity - n, running);
+        CHECK(r.consumed == ref.consumed && r.produced == ref.produced && running == refRunning);
+        refPos += ref.consumed, refN += ref.produced, pos += r.consumed, n += r.produced;
+        if (refPos != pos)
+          break;
+      }
+      for (std::size_t i = 0; i < n && i < refN; ++i)
+        CHECK(test::same(events[i], expected[i]));
+    }
+  }
+
+  // Mostly known message types, some reserved ones
+  std::vector<std::uint32_t> randomWords(test::Rng &rng, std::size_t packets)
+  {
+    std::vector<std::uint32_t> words;
+    for (; packets; --packets)
+    {
+      const std::uint32_t mt = rng() % 8 ? rng() % 6 : rng() % 16;
+      words.push_back(mt << 28 | (rng() & 0x0FFFFFFF));
+      for (std::size_t i = 1; i < UmpFraming::packetWords(words.back()); ++i)
+        words.push_back(rng());
+    }
+    return words;
+  }
+
+  // Packet by packet, MidiBytes::M2::method on the big-endian bytes
+  BatchInfo interpretPackets(const std::uint32_t *words, std::size_t count, MidiEvent *events, std::size_t capacity)
+  {
+    std::size_t pos = 0;
+    std::size_t n = 0;
+    while (pos < count && n < capacity)
+    {
+      const std::size_t sz = UmpFraming::packetWords(words[pos]);
+      if (pos + sz > count)
+        break;
+      std::uint8_t packet[16]{};
+      for (std::size_t i = 0; i < 4 * sz; ++i)
+        packet[i] = static_cast<std::uint8_t>(words[pos + i / 4] >> (24 - 8 * (i % 4)));
+      if (MidiBytes::M2::method(packet, 4 * sz, events + n).status() == ParseInfo::E::SUCCESS)
+        events[n++].payload = nullptr;
+      pos += sz;
+    }
+    return {pos, n};
+  }
+
+  void interpretWords(test::Rng &rng)
+  {
+    std::size_t produced = 0;
+    for (int round = 0; round < 5000; ++round)
+    {
+      std::vector<std::uint32_t> words = randomWords(rng, rng() % 64);
+      // A trailing partial packet, left unconsumed
+      if (!words.empty() && rng() % 2)
+        words.resize(words.size() - 1 - rng() % (words.size() < 3 ? words.size() : 3));
+      const std::size_t capacity = rng() % 4 ? words.size() : rng() % (words.size() + 1);
+      std::vector<MidiEvent> expected(capacity + 1), events(capacity + 1);
+
+      const BatchInfo ref = interpretPackets(words.data(), words.size(), expected.data(), capacity);
+      const BatchInfo r = MidiBytes::InterpretWords(words.data(), words.size(), events.data(), capacity);
+      CHECK(r.consumed == ref.consumed && r.produced == ref.produced);
+      CHECK(r.produced <= capacity);
+      for (std::size_t i = 0; i < r.produced && i < ref.produced; ++i)
+        CHECK(test::same(events[i], expected[i]));
+      produced += r.produced;
+    }
+    CHECK(produced > 0);
+  }
+} // namespace
+
+int main()
+{
+  test::Rng rng{0x2021};
+  interpretBatch(rng);
+  interpretWords(rng);
+  return test::report("interpret_batch");
+}
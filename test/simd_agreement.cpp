@@ -0,0 +1,397 @@
+/**
+ * @file simd_agreement.cpp
+ * @author Etienne SANTOUL github.com/esantoul
+ * @brief The SIMD kernels against scalar references, over random inputs of every length & alignment.
+ * Built with the default flags (SSE2 on x86-64), with -mavx2 & with MIDI_SIMD_DISABLE, so that all paths agree
+ * @version 0.1
+ * @date 2021-02-04
+ *
+ * @copyright BSD 2-Clause License. Copyright (c) 2021, Etienne SANTOUL. All rights reserved.
+ */
+
+#include "midi_downconvert.hpp"
+#include "midi_filter.hpp"
+#include "sample_dump.hpp"
+#include "simd_config.hpp"
+#include "status_scanner.hpp"
+#include "sysex_codec.hpp"
+#include "test.hpp"
+#include "../src/midi_parser.cpp.template"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+namespace
+{
+  constexpr const char *path()
+  {
+#if defined(MIDI_SIMD_AVX2)
+    return "avx2";
+#elif defined(MIDI_SIMD_SSE2)
+    return "sse2";
+#else
+    return "scalar";
+#endif
+  }
+
+  // Random bytes, `offset` bytes into the returned buffer to exercise unaligned loads
+  std::vector<std::uint8_t> randomBytes(test::Rng &rng, std::size_t offset, std::size_t length, std::uint8_t mask = 0xFF)
+  {
+    std::vector<std::uint8_t> bytes(offset + length);
+    for (auto &b : bytes)
+      b = rng() & mask;
+    return bytes;
+  }
+
+  void sampleDump(test::Rng &rng)
+  {
+    for (std::size_t length = 0; length < 300; ++length)
+    {
+      const std::size_t offset = rng() % 16;
+      const std::vector<std::uint8_t> bytes = randomBytes(rng, offset, length);
+      std::uint8_t x = 0, o = 0;
+      for (std::size_t i = 0; i < length; ++i)
+        x ^= bytes[offset + i], o |= bytes[offset + i];
+      CHECK(SdsUnpack::checksum(bytes.data() + offset, length) == x);
+      const SdsUnpack::Sum s = SdsUnpack::sum(bytes.data() + offset, length);
+      CHECK(s.xors == x && s.ors == o);
+    }
+
+    for (std::uint8_t bits = 8; bits <= 28; ++bits)
+      for (std::size_t count = 0; count < 80; ++count)
+      {
+        const std::size_t n = (bits + 6u) / 7u;
+        const std::size_t offset = rng() % 16;
+        // Packed samples followed by a random amount of readable slack, the odd status byte anywhere
+        const std::size_t available = n * count + rng() % 40;
+        std::vector<std::uint8_t> bytes = randomBytes(rng, offset, available, 0x7F);
+        if (available && rng() % 4 == 0)
+          bytes[offset + rng() % available] |= 0x80;
+        std::vector<std::int32_t> out(count + 1, 0x5A5A5A5A);
+        const SdsUnpack::Sum s = SdsUnpack::unpack(bytes.data() + offset, available, bits, out.data(), count);
+        std::uint8_t x = 0, o = 0;
+        for (std::size_t i = 0; i < available; ++i)
+          x ^= bytes[offset + i], o |= bytes[offset + i];
+        CHECK(s.xors == x && s.ors == o);
+        for (std::size_t i = 0; i < count; ++i)
+        {
+          std::uint32_t v = 0;
+          for (std::size_t b = 0; b < n; ++b)
+            v = v << 7 | (bytes[offset + n * i + b] & 0x7F);
+          v = v << (32 - 7 * n) >> (32 - bits) << (32 - bits);
+          CHECK(out[i] == static_cast<std::int32_t>(v ^ 0x80000000));
+        }
+        CHECK(out[count] == 0x5A5A5A5A);
+      }
+
+    // Whole decoder, fed raw bytes & SysExView: corrupt packets & corrupt retransmissions leave the received samples
+    for (std::uint8_t bits : {8, 16, 21, 28})
+    {
+      const std::size_t n = (bits + 6u) / 7u;
+      const std::size_t length = 10 * (120 / n) - 3;
+      const std::vector<std::uint8_t> header = {0xF0, 0x7E, 0x00, 0x01, 0x00, 0x00, bits, 0x00, 0x00, 0x01, std::uint8_t(length & 0x7F),
+                                                std::uint8_t(length >> 7), 0, 0, 0, 0, 0, 0, 0, 0x7F, 0xF7};
+      std::vector<std::int32_t> raw(length), viewed(length), expected(length);
+      SampleDumpDecoder a{raw.data(), length}, b{viewed.data(), length};
+      CHECK(a.feed(header.data(), header.size()) == SdsStatus::Header);
+      CHECK(b.feed(SysExView::parse(header.data(), header.size())) == SdsStatus::Header);
+      const auto feed = [&](const std::vector<std::uint8_t> &packet, SdsStatus status) {
+        CHECK(a.feed(packet.data(), packet.size()) == status);
+        CHECK(b.feed(SysExView::parse(packet.data(), packet.size())) == status);
+        // Past the received samples the buffer is scratch space
+        CHECK(a.received() == b.received());
+        CHECK(std::equal(raw.begin(), raw.begin() + a.received(), expected.begin()));
+        CHECK(std::equal(viewed.begin(), viewed.begin() + b.received(), expected.begin()));
+      };
+      std::vector<std::uint8_t> previous;
+      for (std::size_t k = 0; k < 10; ++k)
+      {
+        std::vector<std::uint8_t> packet = randomBytes(rng, 0, 127, 0x7F);
+        packet[0] = 0xF0, packet[1] = 0x7E, packet[2] = 0x00, packet[3] = 0x02, packet[4] = static_cast<std::uint8_t>(k);
+        packet[125] = SdsUnpack::checksum(packet.data() + 1, 124) & 0x7F;
+        packet[126] = 0xF7;
+
+        std::vector<std::uint8_t> bad = packet;
+        bad[125] ^= 1;
+        feed(bad, SdsStatus::Checksum);
+        bad = packet;
+        bad[5 + rng() % 120] |= 0x80;
+        feed(bad, SdsStatus::Ignored);
+        if (k)
+        {
+          bad = previous;
+          bad[5 + rng() % 120] ^= 1;
+          feed(bad, SdsStatus::Checksum);
+        }
+
+        for (std::size_t i = 0; i < 120 / n && k * (120 / n) + i < length; ++i)
+        {
+          std::uint32_t v = 0;
+          for (std::size_t j = 0; j < n; ++j)
+            v = v << 7 | packet[5 + n * i + j];
+          v = v << (32 - 7 * n) >> (32 - bits) << (32 - bits);
+          expected[k * (120 / n) + i] = static_cast<std::int32_t>(v ^ 0x80000000);
+        }
+        feed(packet, k == 9 ? SdsStatus::Complete : SdsStatus::Packet);
+        feed(packet, k == 9 ? SdsStatus::Complete : SdsStatus::Packet); // retransmission
+        previous = packet;
+      }
+    }
+  }
+
+  // Output of `length` bytes followed by guard bytes that must stay untouched
+  struct Guarded
+  {
+    explicit Guarded(std::size_t length) : bytes(length + 16, 0xA5), length{length} {}
+    std::uint8_t *data() { return bytes.data(); }
+    bool intact() const
+    {
+      for (std::size_t i = length; i < bytes.size(); ++i)
+        if (bytes[i] != 0xA5)
+          return false;
+      return true;
+    }
+    std::vector<std::uint8_t> bytes;
+    std::size_t length;
+  };
+
+  void sysexCodec(test::Rng &rng)
+  {
+    for (const HeaderBits order : {HeaderBits::FirstHigh, HeaderBits::FirstLow})
+      for (std::size_t length = 0; length < 300; ++length)
+      {
+        const auto bit = [order](std::size_t i) { return order == HeaderBits::FirstHigh ? 6 - i : i; };
+        const std::size_t offset = rng() % 16;
+        const std::vector<std::uint8_t> data = randomBytes(rng, offset, length);
+
+        std::vector<std::uint8_t> packed;
+        for (std::size_t g = 0; g < length; g += 7)
+        {
+          std::uint8_t header = 0;
+          for (std::size_t i = 0; i < 7 && g + i < length; ++i)
+            header |= (data[offset + g + i] >> 7) << bit(i);
+          packed.push_back(header);
+          for (std::size_t i = 0; i < 7 && g + i < length; ++i)
+            packed.push_back(data[offset + g + i] & 0x7F);
+        }
+        Guarded out{SysExCodec::packedSize(length)};
+        CHECK(SysExCodec::pack(data.data() + offset, length, out.data(), order) == packed.size());
+        CHECK(std::equal(packed.data(), packed.data() + packed.size(), out.data()) && out.intact());
+
+        // In place: the input at the start of a buffer of the packed size
+        std::vector<std::uint8_t> inPlace(packed.size());
+        std::copy(data.data() + offset, data.data() + offset + length, inPlace.data());
+        SysExCodec::pack(inPlace.data(), length, inPlace.data(), order);
+        CHECK(inPlace == packed);
+
+        // Decoding any 7-bit stream, header bits & MSBs beyond the format set at random
+        const std::vector<std::uint8_t> coded = randomBytes(rng, offset, length);
+        std::vector<std::uint8_t> decoded;
+        for (std::size_t g = 0; g < length; g += 8)
+          for (std::size_t i = 0; i < 7 && g + 1 + i < length; ++i)
+            decoded.push_back(static_cast<std::uint8_t>((coded[offset + g + 1 + i] & 0x7F) | ((coded[offset + g] >> bit(i)) & 1) << 7));
+        Guarded back{SysExCodec::unpackedSize(length)};
+        CHECK(SysExCodec::unpack(coded.data() + offset, length, back.data(), order) == decoded.size());
+        CHECK(std::equal(decoded.data(), decoded.data() + decoded.size(), back.data()) && back.intact());
+
+        std::vector<std::uint8_t> roundTrip(packed);
+        CHECK(SysExCodec::unpack(roundTrip.data(), roundTrip.size(), roundTrip.data(), order) == length);
+        CHECK(std::equal(data.data() + offset, data.data() + offset + length, roundTrip.data()));
+      }
+
+    for (const NibbleOrder order : {NibbleOrder::HighFirst, NibbleOrder::LowFirst})
+      for (std::size_t length = 0; length < 300; ++length)
+      {
+        const bool high = order == NibbleOrder::HighFirst;
+        const std::size_t offset = rng() % 16;
+        const std::vector<std::uint8_t> data = randomBytes(rng, offset, length);
+
+        std::vector<std::uint8_t> nibbles;
+        for (std::size_t i = 0; i < length; ++i)
+        {
+          nibbles.push_back(high ? data[offset + i] >> 4 : data[offset + i] & 0x0F);
+          nibbles.push_back(high ? data[offset + i] & 0x0F : data[offset + i] >> 4);
+        }
+        Guarded out{SysExCodec::nibblizedSize(length)};
+        CHECK(SysExCodec::nibblize(data.data() + offset, length, out.data(), order) == nibbles.size());
+        CHECK(std::equal(nibbles.data(), nibbles.data() + nibbles.size(), out.data()) && out.intact());
+
+        std::vector<std::uint8_t> inPlace(nibbles.size());
+        std::copy(data.data() + offset, data.data() + offset + length, inPlace.data());
+        SysExCodec::nibblize(inPlace.data(), length, inPlace.data(), order);
+        CHECK(inPlace == nibbles);
+
+        // Decoding, high nibbles set at random & a trailing odd byte ignored
+        const std::vector<std::uint8_t> coded = randomBytes(rng, offset, length);
+        std::vector<std::uint8_t> decoded;
+        for (std::size_t i = 0; i + 1 < length; i += 2)
+        {
+          const std::uint8_t first = coded[offset + i] & 0x0F;
+          const std::uint8_t second = coded[offset + i + 1] & 0x0F;
+          decoded.push_back(static_cast<std::uint8_t>(high ? first << 4 | second : second << 4 | first));
+        }
+        Guarded back{length / 2};
+        CHECK(SysExCodec::denibblize(coded.data() + offset, length, back.data(), order) == decoded.size());
+        CHECK(std::equal(decoded.data(), decoded.data() + decoded.size(), back.data()) && back.intact());
+
+        std::vector<std::uint8_t> roundTrip(nibbles);
+        CHECK(SysExCodec::denibblize(roundTrip.data(), roundTrip.size(), roundTrip.data(), order) == length);
+        CHECK(std::equal(data.data() + offset, data.data() + offset + length, roundTrip.data()));
+      }
+  }
+
+  void statusScanner(test::Rng &rng)
+  {
+    for (std::size_t length = 0; length < 300; ++length)
+    {
+      const std::size_t offset = rng() % 16;
+      // One byte in four in the F0-FF range, so that SysEx delimiters & realtime bytes are frequent
+      std::vector<std::uint8_t> bytes = randomBytes(rng, offset, length);
+      for (auto &b : bytes)
+        if (rng() % 4 == 0)
+          b |= 0xF0;
+
+      const std::size_t words = StatusScanner::words(length);
+      std::vector<std::uint64_t> status(words + 1, ~0ull), sysex(words + 1, ~0ull), realtime(words + 1, ~0ull);
+      StatusScanner::scan(bytes.data() + offset, length, {status.data(), sysex.data(), realtime.data()});
+
+      std::vector<std::uint64_t> st(words), sx(words), rt(words);
+      std::vector<std::uint32_t> statusOffsets;
+      for (std::size_t i = 0; i < length; ++i)
+      {
+        const std::uint8_t b = bytes[offset + i];
+        const std::uint64_t bit = std::uint64_t{1} << (i % 64);
+        st[i / 64] |= b >= 0x80 ? bit : 0;
+        sx[i / 64] |= b == 0xF0 || b == 0xF7 ? bit : 0;
+        rt[i / 64] |= b >= 0xF8 ? bit : 0;
+        if (b >= 0x80)
+          statusOffsets.push_back(static_cast<std::uint32_t>(i));
+      }
+      CHECK(std::equal(st.begin(), st.end(), status.begin()) && status[words] == ~0ull);
+      CHECK(std::equal(sx.begin(), sx.end(), sysex.begin()) && sysex[words] == ~0ull);
+      CHECK(std::equal(rt.begin(), rt.end(), realtime.begin()) && realtime[words] == ~0ull);
+
+      // Offsets, in full & cut short by the capacity
+      std::vector<std::uint32_t> found(statusOffsets.size() + 1);
+      const std::size_t max = rng() % (statusOffsets.size() + 1);
+      CHECK(StatusScanner::offsets(status.data(), length, found.data(), found.size()) == statusOffsets.size());
+      CHECK(std::equal(statusOffsets.begin(), statusOffsets.end(), found.begin()));
+      CHECK(StatusScanner::offsets(status.data(), length, found.data(), max) == max);
+    }
+  }
+
+  void downConvert(test::Rng &rng)
+  {
+    for (std::size_t count = 0; count < 300; ++count)
+    {
+      const std::size_t offset = rng() % 8;
+      std::vector<std::uint32_t> values(offset + count);
+      for (auto &v : values)
+        v = rng() % 8 ? rng() : (rng() & 1 ? 0xFFFFFFFF : 0x80000000);
+      std::vector<std::uint16_t> out(count + 8, 0x5A5A);
+      ValueScale::to14Bits(values.data() + offset, count, out.data());
+      for (std::size_t i = 0; i < count; ++i)
+        CHECK(out[i] == ValueScale::down(values[offset + i], 32, 14));
+      CHECK(std::all_of(out.begin() + count, out.end(), [](std::uint16_t v) { return v == 0x5A5A; }));
+    }
+
+    // The batch conversion scales in blocks, it must write what event by event conversion writes
+    constexpr EventType types[] = {EventType::NoteOff,       EventType::NoteOn,        EventType::PolyPressure,
+                                   EventType::ControlChange, EventType::ProgramChange, EventType::ChannelPressure,
+                                   EventType::PitchBend,     EventType::RegistCtrl,    EventType::RelativeRegistCtrl};
+    for (int round = 0; round < 200; ++round)
+    {
+      std::vector<MidiEvent> events(rng() % 300);
+      for (auto &e : events)
+      {
+        e.type = types[rng() % (sizeof types / sizeof *types)];
+        e.protocol = rng() % 4 ? 2 : 1;
+        e.channel = rng() % 4;
+        e.data1 = rng() & 0x7F;
+        e.data2 = rng() & 0x7F;
+        e.data16 = static_cast<std::uint16_t>(rng());
+        e.value = e.protocol == 2 ? rng() : rng() & (e.type == EventType::PitchBend ? 0x3FFF : 0x7F);
+      }
+      const bool runningStatus = rng() & 1;
+      Midi1DownConverter single{runningStatus};
+      std::vector<std::uint8_t> expected(Midi1DownConverter::maxSize * events.size());
+      std::size_t n = 0;
+      for (const MidiEvent &e : events)
+        n += single.convert(e, expected.data() + n, expected.size() - n);
+
+      Midi1DownConverter batch{runningStatus};
+      std::vector<std::uint8_t> bytes(expected.size());
+      const BatchInfo info = batch.convert(events.data(), events.size(), bytes.data(), bytes.size());
+      CHECK(info.consumed == events.size() && info.produced == n);
+      CHECK(std::equal(expected.begin(), expected.begin() + n, bytes.begin()));
+    }
+  }
+
+  void filterWords(test::Rng &rng)
+  {
+    for (int round = 0; round < 2000; ++round)
+    {
+      MidiFilter filter{(rng() & 1) != 0};
+      for (int k = rng() % 32; k; --k)
+        filter.setUmp(rng() % 16, rng() % 16, static_cast<std::uint16_t>(rng()), static_cast<std::uint16_t>(rng()));
+
+      // Mostly runs of single word packets (utility, system & MIDI 1.0 channel voice) for the AVX2 path, ended by a
+      // packet that may be cut short
+      const std::size_t offset = rng() % 8;
+      std::vector<std::uint32_t> words(offset);
+      for (std::size_t packets = rng() % 100; packets; --packets)
+      {
+        const std::uint32_t mt = rng() % 4 ? rng() % 3 : rng() % 16;
+        const std::uint32_t w0 = mt << 28 | (rng() & 0x0FFFFFFF);
+        words.push_back(w0);
+        for (std::size_t i = 1; i < UmpFraming::packetWords(w0); ++i)
+          words.push_back(rng());
+      }
+      if (words.size() > offset && rng() % 4 == 0)
+        words.pop_back();
+      const std::size_t count = words.size() - offset;
+
+      std::vector<std::uint32_t> expected;
+      std::size_t pos = offset;
+      while (pos < words.size() && pos + UmpFraming::packetWords(words[pos]) <= words.size())
+      {
+        const std::size_t sz = UmpFraming::packetWords(words[pos]);
+        if (filter.pass(words[pos]))
+          expected.insert(expected.end(), words.begin() + pos, words.begin() + pos + sz);
+        pos += sz;
+      }
+
+      std::vector<std::uint32_t> out(count + 1, 0x5A5A5A5A);
+      const BatchInfo info = filter.filterWords(words.data() + offset, count, out.data());
+      CHECK(info.consumed == pos - offset && info.produced == expected.size());
+      CHECK(std::equal(expected.begin(), expected.end(), out.begin()));
+      CHECK(std::all_of(out.begin() + expected.size(), out.end(), [](std::uint32_t w) { return w == 0x5A5A5A5A; }));
+
+      const BatchInfo inPlace = filter.filterWords(words.data() + offset, count, words.data() + offset);
+      CHECK(inPlace.consumed == info.consumed && inPlace.produced == info.produced);
+      CHECK(std::equal(expected.begin(), expected.end(), words.begin() + offset));
+    }
+  }
+} // namespace
+
+int main()
+{
+#if defined(MIDI_SIMD_AVX2) && (defined(__GNUC__) || defined(__clang__))
+  if (!__builtin_cpu_supports("avx2"))
+  {
+    std::printf("simd_agreement [avx2]: skipped, no AVX2 on this host\n");
+    return 0;
+  }
+#endif
+  test::Rng rng{0x2021};
+  sampleDump(rng);
+  sysexCodec(rng);
+  statusScanner(rng);
+  downConvert(rng);
+  filterWords(rng);
+
+  char name[64];
+  std::snprintf(name, sizeof name, "simd_agreement [%s]", path());
+  return test::report(name);
+}
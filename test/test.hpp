@@ -0,0 +1,60 @@
+#ifndef TEST_HPP
+#define TEST_HPP
+
+/**
+ * @file test.hpp
+ * @author Etienne SANTOUL github.com/esantoul
+ * @brief Minimal check macro & deterministic random source shared by the tests
+ * @version 0.1
+ * @date 2021-02-04
+ *
+ * @copyright BSD 2-Clause License. Copyright (c) 2021, Etienne SANTOUL. All rights reserved.
+ */
+
+#include "midi_event.hpp"
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+namespace test
+{
+  inline int failures = 0;
+
+  inline void fail(const char *file, int line, const char *expr)
+  {
+    if (++failures <= 20)
+      std::fprintf(stderr, "%s:%d: check failed: %s\n", file, line, expr);
+  }
+
+  // @return the process exit code
+  inline int report(const char *name)
+  {
+    std::printf("%s: %s (%d failures)\n", name, failures ? "FAILED" : "passed", failures);
+    return failures ? 1 : 0;
+  }
+
+  // Field by field event comparison, payloads compared by content
+  inline bool same(const MidiEvent &a, const MidiEvent &b)
+  {
+    return a.type == b.type && a.protocol == b.protocol && a.group == b.group && a.channel == b.channel &&
+           a.data1 == b.data1 && a.data2 == b.data2 && a.data16 == b.data16 && a.value == b.value && a.length == b.length &&
+           (!a.payload == !b.payload) && (!a.payload || !a.length || std::memcmp(a.payload, b.payload, a.length) == 0);
+  }
+
+  // xorshift32, reproducible across platforms
+  struct Rng
+  {
+    std::uint32_t state;
+    std::uint32_t operator()()
+    {
+      state ^= state << 13;
+      state ^= state >> 17;
+      state ^= state << 5;
+      return state;
+    }
+  };
+} // namespace test
+
+#define CHECK(expr) ((expr) ? (void)0 : test::fail(__FILE__, __LINE__, #expr))
+
+#endif // TEST_HPP